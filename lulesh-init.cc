@@ -3,17 +3,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <hpx/algorithm.hpp>
+#include <hpx/execution.hpp>
 #include "lulesh.h"
 
 /////////////////////////////////////////////////////////////////////
 Domain::Domain(Int_t numRanks, Index_t colLoc,
                Index_t rowLoc, Index_t planeLoc,
-               Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost)
+               Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost,
+               std::shared_ptr<MeshConnectivity> mesh)
    :
    m_regElemSize(0),
    m_regNumList(0),
    m_regElemlist(0),
+   m_eosRepWork(0),
+   m_mesh(mesh),
 
    m_e_cut(Real_t(1.0e-7)),
    m_p_cut(Real_t(1.0e-7)),
@@ -47,6 +54,14 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    Index_t edgeNodes = edgeElems+1 ;
    this->cost() = cost;
 
+   // the setup steps run in parallel; their times are recorded in order
+   double stamp = WallTime() ;
+   auto record = [this, &stamp](const char *step) {
+      double now = WallTime() ;
+      m_setupTimes.push_back(std::make_pair(step, now - stamp)) ;
+      stamp = now ;
+   } ;
+
    m_tp       = tp ;
    m_numRanks = numRanks ;
 
@@ -69,6 +84,14 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
 
    m_regNumList = new Index_t[numElem()] ;  // material indexset
 
+   // the connectivity, volumes and masses of a shared mesh have been set up
+   // by its first domain
+   bool buildConnectivity = !m_mesh ;
+   if (buildConnectivity) {
+      m_mesh = std::make_shared<MeshConnectivity>() ;
+      AllocateMeshConnectivity(numElem(), numNode()) ;
+   }
+
    // Elem-centered
    AllocateElemPersistent(numElem()) ;
 
@@ -76,55 +99,133 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    AllocateNodePersistent(numNode()) ;
 
    SetupCommBuffers(edgeNodes);
+   record("allocation") ;
 
-   // Basic Field Initialization
-   for (Index_t i=0; i<numElem(); ++i) {
-      e(i) =  Real_t(0.0) ;
-      p(i) =  Real_t(0.0) ;
-      q(i) =  Real_t(0.0) ;
-      ss(i) = Real_t(0.0) ;
-   }
-
-   // Note - v initializes to 1.0, not 0.0!
-   for (Index_t i=0; i<numElem(); ++i) {
-      v(i) = Real_t(1.0) ;
-   }
+   InitializeFields() ;
+   record("field initialization") ;
 
-   for (Index_t i=0; i<numNode(); ++i) {
-      xd(i) = Real_t(0.0) ;
-      yd(i) = Real_t(0.0) ;
-      zd(i) = Real_t(0.0) ;
-   }
+   BuildMesh(nx, edgeNodes, edgeElems);
+   if (buildConnectivity)
+      BuildElemNodeLists(edgeNodes, edgeElems);
+   record("mesh") ;
 
-   for (Index_t i=0; i<numNode(); ++i) {
-      xdd(i) = Real_t(0.0) ;
-      ydd(i) = Real_t(0.0) ;
-      zdd(i) = Real_t(0.0) ;
+   if (buildConnectivity) {
+      SetupThreadSupportStructures();
    }
-
-   for (Index_t i=0; i<numNode(); ++i) {
-      nodalMass(i) = Real_t(0.0) ;
+   else {
+      m_nodeElemStart = m_mesh->nodeElemStart.data() ;
+      m_nodeElemCornerList = m_mesh->nodeElemCornerList.data() ;
    }
-
-   BuildMesh(nx, edgeNodes, edgeElems);
-
-   SetupThreadSupportStructures();
+   record("node-element lists") ;
 
    // Setup region index sets. For now, these are constant sized
    // throughout the run, but could be changed every cycle to
    // simulate effects of ALE on the lagrange solver
    CreateRegionIndexSets(nr, balance);
+   record("region index sets") ;
 
    // Setup symmetry nodesets
    SetupSymmetryPlanes(edgeNodes);
 
-   // Setup element connectivities
-   SetupElementConnectivities(edgeElems);
+   if (buildConnectivity) {
+      // Setup element connectivities
+      SetupElementConnectivities(edgeElems);
+
+      // Setup symmetry planes and free surface boundary arrays
+      SetupBoundaryConditions(edgeElems);
+   }
+   record("connectivity and boundary conditions") ;
+
+   if (buildConnectivity) {
+      // initialize field data
+      hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numElem()),
+                    [this](Index_t i) {
+         Real_t x_local[8], y_local[8], z_local[8] ;
+         Index_t *elemToNode = nodelist(i) ;
+         for( Index_t lnode=0 ; lnode<8 ; ++lnode )
+         {
+           Index_t gnode = elemToNode[lnode];
+           x_local[lnode] = x(gnode);
+           y_local[lnode] = y(gnode);
+           z_local[lnode] = z(gnode);
+         }
+
+         // volume calculations
+         Real_t volume = CalcElemVolume(x_local, y_local, z_local );
+         volo(i) = volume ;
+         elemMass(i) = volume ;
+      }) ;
+
+      // gather the nodal masses over the node-element lists, which are in
+      // element order, so the sums are added up as by a sequential scatter
+      hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numNode()),
+                    [this](Index_t i) {
+         Real_t mass = Real_t(0.0) ;
+         for (Index_t j=m_nodeElemStart[i]; j<m_nodeElemStart[i+1]; ++j) {
+            mass += volo(m_nodeElemCornerList[j] / 8) / Real_t(8.0) ;
+         }
+         nodalMass(i) = mass ;
+      }) ;
+   }
+   record("volumes and nodal mass") ;
+
+   SetupInitialConditions(nx) ;
+
+} // End constructor
+
+
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::Reset(Int_t nr, Int_t balance, Int_t cost)
+{
+   Index_t edgeElems = m_sizeX ;
+   this->cost() = cost ;
+
+   InitializeFields() ;
+   BuildMesh(edgeElems, edgeElems+1, edgeElems) ;
+
+   delete [] m_regElemSize ;
+   for (Index_t i=0 ; i<numReg() ; ++i) {
+     delete [] m_regElemlist[i] ;
+   }
+   delete [] m_regElemlist ;
+   CreateRegionIndexSets(nr, balance) ;
+
+   SetupInitialConditions(edgeElems) ;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::InitializeFields()
+{
+   // Basic Field Initialization
+   hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numElem()),
+                 [this](Index_t i) {
+      e(i) =  Real_t(0.0) ;
+      p(i) =  Real_t(0.0) ;
+      q(i) =  Real_t(0.0) ;
+      ss(i) = Real_t(0.0) ;
+      // Note - v initializes to 1.0, not 0.0!
+      v(i) = Real_t(1.0) ;
+   }) ;
 
-   // Setup symmetry planes and free surface boundary arrays
-   SetupBoundaryConditions(edgeElems);
+   hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numNode()),
+                 [this](Index_t i) {
+      xd(i) = Real_t(0.0) ;
+      yd(i) = Real_t(0.0) ;
+      zd(i) = Real_t(0.0) ;
+      xdd(i) = Real_t(0.0) ;
+      ydd(i) = Real_t(0.0) ;
+      zdd(i) = Real_t(0.0) ;
+   }) ;
+}
 
 
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::SetupInitialConditions(Index_t nx)
+{
    // Setup defaults
 
    // These can be changed (requires recompile) if you want to run
@@ -140,32 +241,12 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    deltatimemultub() = Real_t(1.2) ;
    dtcourant() = Real_t(1.0e+20) ;
    dthydro()   = Real_t(1.0e+20) ;
+   cycleDtCourant() = Real_t(1.0e+20) ;
+   cycleDtHydro()   = Real_t(1.0e+20) ;
    dtmax()     = Real_t(1.0e-2) ;
    time()    = Real_t(0.) ;
    cycle()   = Int_t(0) ;
 
-   // initialize field data
-   for (Index_t i=0; i<numElem(); ++i) {
-      Real_t x_local[8], y_local[8], z_local[8] ;
-      Index_t *elemToNode = nodelist(i) ;
-      for( Index_t lnode=0 ; lnode<8 ; ++lnode )
-      {
-        Index_t gnode = elemToNode[lnode];
-        x_local[lnode] = x(gnode);
-        y_local[lnode] = y(gnode);
-        z_local[lnode] = z(gnode);
-      }
-
-      // volume calculations
-      Real_t volume = CalcElemVolume(x_local, y_local, z_local );
-      volo(i) = volume ;
-      elemMass(i) = volume ;
-      for (Index_t j=0; j<8; ++j) {
-         Index_t idx = elemToNode[j] ;
-         nodalMass(idx) += volume / Real_t(8.0) ;
-      }
-   }
-
    // deposit initial energy
    // An energy of 3.948746e+7 is correct for a problem with
    // 45 zones along a side - we need to scale it
@@ -179,16 +260,13 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    }
    //set initial deltatime base on analytic CFL calculation
    deltatime() = (Real_t(.5)*cbrt(volo(0)))/sqrt(Real_t(2.0)*einit);
-
-} // End constructor
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////
 Domain::~Domain()
 {
    delete [] m_regNumList;
-   delete [] m_nodeElemStart;
-   delete [] m_nodeElemCornerList;
    delete [] m_regElemSize;
    for (Index_t i=0 ; i<numReg() ; ++i) {
      delete [] m_regElemlist[i];
@@ -204,10 +282,11 @@ Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
 {
   Index_t meshEdgeElems = m_tp*nx ;
 
-  // initialize nodal coordinates
-  Index_t nidx = 0 ;
-  Real_t tz = Real_t(1.125)*Real_t(m_planeLoc*nx)/Real_t(meshEdgeElems) ;
-  for (Index_t plane=0; plane<edgeNodes; ++plane) {
+  // initialize nodal coordinates, one plane per iteration
+  hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(edgeNodes),
+                [this, nx, edgeNodes, meshEdgeElems](Index_t plane) {
+    Index_t nidx = plane*edgeNodes*edgeNodes ;
+    Real_t tz = Real_t(1.125)*Real_t(m_planeLoc*nx+plane)/Real_t(meshEdgeElems) ;
     Real_t ty = Real_t(1.125)*Real_t(m_rowLoc*nx)/Real_t(meshEdgeElems) ;
     for (Index_t row=0; row<edgeNodes; ++row) {
       Real_t tx = Real_t(1.125)*Real_t(m_colLoc*nx)/Real_t(meshEdgeElems) ;
@@ -222,15 +301,19 @@ Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
       // ty += ds ;  // may accumulate roundoff...
       ty = Real_t(1.125)*Real_t(m_rowLoc*nx+row+1)/Real_t(meshEdgeElems) ;
     }
-    // tz += ds ;  // may accumulate roundoff...
-    tz = Real_t(1.125)*Real_t(m_planeLoc*nx+plane+1)/Real_t(meshEdgeElems) ;
-  }
+  }) ;
+}
 
 
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::BuildElemNodeLists(Int_t edgeNodes, Int_t edgeElems)
+{
   // embed hexehedral elements in nodal point lattice
-  Index_t zidx = 0 ;
-  nidx = 0 ;
-  for (Index_t plane=0; plane<edgeElems; ++plane) {
+  hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(edgeElems),
+                [this, edgeNodes, edgeElems](Index_t plane) {
+    Index_t zidx = plane*edgeElems*edgeElems ;
+    Index_t nidx = plane*edgeNodes*edgeNodes ;
     for (Index_t row=0; row<edgeElems; ++row) {
       for (Index_t col=0; col<edgeElems; ++col) {
 	Index_t *localNode = nodelist(zidx) ;
@@ -247,8 +330,7 @@ Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
       }
       ++nidx ;
     }
-    nidx += edgeNodes ;
-  }
+  }) ;
 }
 
 
@@ -256,54 +338,66 @@ Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
 void
 Domain::SetupThreadSupportStructures()
 {
-    // set up node-centered indexing of elements
-    Index_t *nodeElemCount = new Index_t[numNode()] ;
-
-    for (Index_t i=0; i<numNode(); ++i) {
-      nodeElemCount[i] = 0 ;
-    }
-
-    for (Index_t i=0; i<numElem(); ++i) {
+    // set up node-centered indexing of elements: count the corners of each
+    // node, prefix sum of the counts, then place the corners in parallel and
+    // sort the list of each node, which gives the element order of a
+    // sequential fill
+    std::atomic<Index_t> *nodeElemCount = new std::atomic<Index_t>[numNode()] ;
+
+    hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numNode()),
+                  [nodeElemCount](Index_t i) {
+      nodeElemCount[i].store(0, std::memory_order_relaxed) ;
+    }) ;
+
+    hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numElem()),
+                  [this, nodeElemCount](Index_t i) {
       Index_t *nl = nodelist(i) ;
       for (Index_t j=0; j < 8; ++j) {
-	++(nodeElemCount[nl[j]] );
+	nodeElemCount[nl[j]].fetch_add(1, std::memory_order_relaxed) ;
       }
-    }
+    }) ;
 
-    m_nodeElemStart = new Index_t[numNode()+1] ;
+    m_mesh->nodeElemStart.resize(numNode()+1) ;
+    m_nodeElemStart = m_mesh->nodeElemStart.data() ;
 
     m_nodeElemStart[0] = 0;
 
-    for (Index_t i=1; i <= numNode(); ++i) {
-      m_nodeElemStart[i] =
-	m_nodeElemStart[i-1] + nodeElemCount[i-1] ;
-    }
-
-    m_nodeElemCornerList = new Index_t[m_nodeElemStart[numNode()]];
+    hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numNode()),
+                  [this, nodeElemCount](Index_t i) {
+      m_nodeElemStart[i+1] = nodeElemCount[i].load(std::memory_order_relaxed) ;
+      nodeElemCount[i].store(0, std::memory_order_relaxed) ;
+    }) ;
+    hpx::inclusive_scan(hpx::execution::par, m_nodeElemStart+1, m_nodeElemStart+numNode()+1,
+                        m_nodeElemStart+1) ;
 
-    for (Index_t i=0; i < numNode(); ++i) {
-      nodeElemCount[i] = 0;
-    }
+    m_mesh->nodeElemCornerList.resize(m_nodeElemStart[numNode()]) ;
+    m_nodeElemCornerList = m_mesh->nodeElemCornerList.data() ;
 
-    for (Index_t i=0; i < numElem(); ++i) {
+    hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numElem()),
+                  [this, nodeElemCount](Index_t i) {
       Index_t *nl = nodelist(i) ;
       for (Index_t j=0; j < 8; ++j) {
 	Index_t m = nl[j];
 	Index_t k = i*8 + j ;
-	Index_t offset = m_nodeElemStart[m] + nodeElemCount[m] ;
+	Index_t offset = m_nodeElemStart[m] +
+	  nodeElemCount[m].fetch_add(1, std::memory_order_relaxed) ;
 	m_nodeElemCornerList[offset] = k;
-	++(nodeElemCount[m]) ;
       }
-    }
+    }) ;
+
+    hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numNode()),
+                  [this](Index_t i) {
+      std::sort(&m_nodeElemCornerList[m_nodeElemStart[i]],
+                &m_nodeElemCornerList[m_nodeElemStart[i+1]]) ;
+    }) ;
 
     Index_t clSize = m_nodeElemStart[numNode()] ;
-    for (Index_t i=0; i < clSize; ++i) {
-      Index_t clv = m_nodeElemCornerList[i] ;
-      if ((clv < 0) || (clv > numElem()*8)) {
+    Index_t maxCorner = numElem()*8 ;
+    if (hpx::any_of(hpx::execution::par, m_nodeElemCornerList, m_nodeElemCornerList + clSize,
+                    [maxCorner](Index_t clv) { return (clv < 0) || (clv > maxCorner) ; })) {
 	fprintf(stderr,
 		"AllocateNodeElemIndexes(): nodeElemCornerList entry out of range!\n");
 	exit(-1);
-      }
     }
 
     delete [] nodeElemCount ;
@@ -341,21 +435,36 @@ Domain::SetupCommBuffers(Int_t edgeNodes)
 void
 Domain::CreateRegionIndexSets(Int_t nr, Int_t balance)
 {
-   srand(0);
+   // Each domain draws from its own generator so that ensemble members
+   // built concurrently get the regions of a separate run; random_r()
+   // seeded with 0 reproduces the rand() sequence after srand(0)
+   struct random_data randState ;
+   int32_t randStateBuf[32] ; // read and written as int32_t by random_r
+   memset(&randState, 0, sizeof(randState)) ;
+   initstate_r(0, reinterpret_cast<char *>(randStateBuf), sizeof(randStateBuf), &randState) ;
+   auto rand = [&randState]() {
+      int32_t r ;
+      random_r(&randState, &r) ;
+      return r ;
+   } ;
    Index_t myRank = 0;
    this->numReg() = nr;
    m_regElemSize = new Index_t[numReg()];
    m_regElemlist = new Index_t*[numReg()];
    Index_t nextIndex = 0;
+   // The regions are drawn as runs of consecutive elements, one run per
+   // few calls to rand(); the elements of the runs are written in parallel
+   struct RegionRun {
+      Index_t start ;
+      Index_t numElem ;
+      Int_t   reg ;     // region index == regnum-1
+   } ;
+   std::vector<RegionRun> runs ;
    //if we only have one region just fill it
    // Fill out the regNumList with material numbers, which are always
    // the region index plus one
    if(numReg() == 1) {
-      while (nextIndex < numElem()) {
-	 this->regNumList(nextIndex) = 1;
-         nextIndex++;
-      }
-      regElemSize(0) = 0;
+      runs.push_back({0, numElem(), 0}) ;
    }
    //If we have more than one region distribute the elements.
    else {
@@ -369,7 +478,6 @@ Domain::CreateRegionIndexSets(Int_t nr, Int_t balance)
       Int_t* regBinEnd = new Int_t[numReg()];
       //Determine the relative weights of all the regions.  This is based off the -b flag.  Balance is the value passed into b.
       for (Index_t i=0 ; i<numReg() ; ++i) {
-         regElemSize(i) = 0;
 	 costDenominator += pow((i+1), balance);  //Total sum of all regions weights
 	 regBinEnd[i] = costDenominator;  //Chance of hitting a given region is (regBinEnd[i] - regBinEdn[i-1])/costDenominator
       }
@@ -414,33 +522,40 @@ Domain::CreateRegionIndexSets(Int_t nr, Int_t balance)
 	 else
 	    elements = rand() % 1537 + 512;
 	 runto = elements + nextIndex;
-	 //Store the elements.  If we hit the end before we run out of elements then just stop.
-         while (nextIndex < runto && nextIndex < numElem()) {
-	    this->regNumList(nextIndex) = regionNum;
-	    nextIndex++;
-	 }
+	 //Store the run.  If we hit the end before we run out of elements then just stop.
+	 runto = std::min(runto, numElem()) ;
+	 runs.push_back({nextIndex, runto - nextIndex, regionNum - 1}) ;
+	 nextIndex = runto ;
 	 lastReg = regionNum;
       }
 
       delete [] regBinEnd;
    }
-   // Convert regNumList to region index sets
-   // First, count size of each region
-   for (Index_t i=0 ; i<numElem() ; ++i) {
-      int r = this->regNumList(i)-1; // region index == regnum-1
-      regElemSize(r)++;
+   // Convert the runs to regNumList and region index sets
+   // First, count size of each region and the offset of each run in the
+   // index set of its region
+   std::vector<Index_t> runOffset(runs.size()) ;
+   for (Index_t i=0 ; i<numReg() ; ++i) {
+      regElemSize(i) = 0;
+   }
+   for (size_t n=0 ; n<runs.size() ; ++n) {
+      runOffset[n] = regElemSize(runs[n].reg) ;
+      regElemSize(runs[n].reg) += runs[n].numElem ;
    }
    // Second, allocate each region index set
    for (Index_t i=0 ; i<numReg() ; ++i) {
       m_regElemlist[i] = new Index_t[regElemSize(i)];
-      regElemSize(i) = 0;
-   }
-   // Third, fill index sets
-   for (Index_t i=0 ; i<numElem() ; ++i) {
-      Index_t r = regNumList(i)-1;       // region index == regnum-1
-      Index_t regndx = regElemSize(r)++; // Note increment
-      regElemlist(r,regndx) = i;
    }
+   // Third, fill regNumList and the index sets
+   hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(Index_t(runs.size())),
+                 [this, &runs, &runOffset](Index_t n) {
+      const RegionRun &run = runs[n] ;
+      Index_t *list = &m_regElemlist[run.reg][runOffset[n]] ;
+      for (Index_t i=0 ; i<run.numElem ; ++i) {
+         this->regNumList(run.start+i) = run.reg+1 ;
+         list[i] = run.start+i ;
+      }
+   }) ;
 
 }
 
@@ -473,30 +588,18 @@ Domain::SetupSymmetryPlanes(Int_t edgeNodes)
 void
 Domain::SetupElementConnectivities(Int_t edgeElems)
 {
-   lxim(0) = 0 ;
-   for (Index_t i=1; i<numElem(); ++i) {
-      lxim(i)   = i-1 ;
-      lxip(i-1) = i ;
-   }
-   lxip(numElem()-1) = numElem()-1 ;
-
-   for (Index_t i=0; i<edgeElems; ++i) {
-      letam(i) = i ;
-      letap(numElem()-edgeElems+i) = numElem()-edgeElems+i ;
-   }
-   for (Index_t i=edgeElems; i<numElem(); ++i) {
-      letam(i) = i-edgeElems ;
-      letap(i-edgeElems) = i ;
-   }
-
-   for (Index_t i=0; i<edgeElems*edgeElems; ++i) {
-      lzetam(i) = i ;
-      lzetap(numElem()-edgeElems*edgeElems+i) = numElem()-edgeElems*edgeElems+i ;
-   }
-   for (Index_t i=edgeElems*edgeElems; i<numElem(); ++i) {
-      lzetam(i) = i - edgeElems*edgeElems ;
-      lzetap(i-edgeElems*edgeElems) = i ;
-   }
+   Index_t planeElems = edgeElems*edgeElems ;
+   Index_t lastElem = numElem()-1 ;
+   // neighbours across the faces, the element itself on the mesh boundary
+   hpx::for_each(hpx::execution::par, counting_iterator(0), counting_iterator(numElem()),
+                 [this, edgeElems, planeElems, lastElem](Index_t i) {
+      lxim(i)   = (i == 0)                    ? i : i-1 ;
+      lxip(i)   = (i == lastElem)             ? i : i+1 ;
+      letam(i)  = (i < edgeElems)             ? i : i-edgeElems ;
+      letap(i)  = (i > lastElem-edgeElems)    ? i : i+edgeElems ;
+      lzetam(i) = (i < planeElems)            ? i : i-planeElems ;
+      lzetap(i) = (i > lastElem-planeElems)   ? i : i+planeElems ;
+   }) ;
 }
 
 /////////////////////////////////////////////////////////////
@@ -506,9 +609,7 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
   Index_t ghostIdx[6] ;  // offsets to ghost locations
 
   // set up boundary condition information
-  for (Index_t i=0; i<numElem(); ++i) {
-     elemBC(i) = Int_t(0) ;
-  }
+  hpx::fill(hpx::execution::par, &elemBC(0), &elemBC(0)+numElem(), Int_t(0)) ;
 
   for (Index_t i=0; i<6; ++i) {
     ghostIdx[i] = INT_MIN ;
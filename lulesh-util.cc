@@ -2,8 +2,11 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <numeric>
 #include "lulesh.h"
 
 /* Helper function for converting strings to ints, with error checking */
@@ -113,3 +116,133 @@ void VerifyAndWriteFinalOutput(Real_t elapsed_time,
 
    return ;
 }
+
+/////////////////////////////////////////////////////////////////////
+
+/* Summary of a set of samples (e.g. task durations), multiplied by scale */
+void PrintSampleStats(std::ostream &out, const char *name,
+                      std::vector<double> samples, double scale,
+                      const char *unit)
+{
+   if (samples.empty()) {
+      out << name << ": no samples\n";
+      return ;
+   }
+   std::sort(samples.begin(), samples.end());
+   size_t n = samples.size();
+   double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+   double var = 0.0;
+   for (double s : samples) {
+      var += (s - mean) * (s - mean);
+   }
+   double stddev = sqrt(var / n);
+
+   std::ios_base::fmtflags flags = out.flags();
+   out << std::fixed << std::setprecision(3);
+   out << name << " (" << unit << "): n=" << n
+       << " min=" << samples.front() * scale
+       << " median=" << samples[n / 2] * scale
+       << " p99=" << samples[std::min(n - 1, (n * 99) / 100)] * scale
+       << " max=" << samples.back() * scale
+       << " mean=" << mean * scale
+       << " stddev=" << stddev * scale
+       << " max/mean=" << (mean > 0.0 ? samples.back() / mean : 0.0) << "\n";
+   out.flags(flags);
+}
+
+/////////////////////////////////////////////////////////////////////
+
+static const char *phaseNames[NumCyclePhases] = {
+   "time_increment", "forces", "nodal", "kinematics", "eos", "constraints"
+} ;
+
+/* Times of one phase over all cycles, sorted */
+static std::vector<double> PhaseSamples(std::vector<CyclePhaseTimes> const &cycles,
+                                        Int_t phase)
+{
+   std::vector<double> samples ;
+   samples.reserve(cycles.size()) ;
+   for (const CyclePhaseTimes &c : cycles) {
+      samples.push_back(c.time[phase]) ;
+   }
+   std::sort(samples.begin(), samples.end()) ;
+   return samples ;
+}
+
+/* Summary of the phase times per cycle */
+void PrintPhaseTimes(std::ostream &out,
+                     std::vector<CyclePhaseTimes> const &cycles)
+{
+   for (Int_t phase = 0; phase < NumCyclePhases; ++phase) {
+      std::string name = std::string("Phase ") + phaseNames[phase] ;
+      PrintSampleStats(out, name.c_str(), PhaseSamples(cycles, phase), 1.0e6, "us") ;
+   }
+}
+
+/* Per-cycle phase times and their min, median, p99, max and mean in
+   seconds; JSON for file names ending in .json, CSV otherwise */
+bool WritePhaseTimes(std::string const &file,
+                     std::vector<CyclePhaseTimes> const &cycles)
+{
+   std::ofstream out(file) ;
+   if (!out) {
+      return false ;
+   }
+   bool json = file.size() >= 5 && file.compare(file.size() - 5, 5, ".json") == 0 ;
+   out << std::setprecision(6) ;
+
+   if (json) {
+      out << "{\n  \"unit\": \"s\",\n  \"cycles\": [" ;
+      for (size_t i = 0; i < cycles.size(); ++i) {
+         out << (i == 0 ? "\n" : ",\n") << "    {\"cycle\": " << cycles[i].cycle ;
+         for (Int_t phase = 0; phase < NumCyclePhases; ++phase) {
+            out << ", \"" << phaseNames[phase] << "\": " << cycles[i].time[phase] ;
+         }
+         out << "}" ;
+      }
+      out << "\n  ],\n  \"summary\": {" ;
+   }
+   else {
+      out << "cycle" ;
+      for (Int_t phase = 0; phase < NumCyclePhases; ++phase) {
+         out << "," << phaseNames[phase] ;
+      }
+      out << "\n" ;
+      for (const CyclePhaseTimes &c : cycles) {
+         out << c.cycle ;
+         for (Int_t phase = 0; phase < NumCyclePhases; ++phase) {
+            out << "," << c.time[phase] ;
+         }
+         out << "\n" ;
+      }
+      out << "\nphase,min,median,p99,max,mean\n" ;
+   }
+
+   for (Int_t phase = 0; phase < NumCyclePhases && !cycles.empty(); ++phase) {
+      std::vector<double> samples = PhaseSamples(cycles, phase) ;
+      size_t n = samples.size() ;
+      double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n ;
+      double stats[5] = { samples.front(), samples[n / 2],
+                          samples[std::min(n - 1, (n * 99) / 100)],
+                          samples.back(), mean } ;
+      if (json) {
+         static const char *statNames[5] = { "min", "median", "p99", "max", "mean" } ;
+         out << (phase == 0 ? "\n" : ",\n") << "    \"" << phaseNames[phase] << "\": {" ;
+         for (int s = 0; s < 5; ++s) {
+            out << (s == 0 ? "" : ", ") << "\"" << statNames[s] << "\": " << stats[s] ;
+         }
+         out << "}" ;
+      }
+      else {
+         out << phaseNames[phase] ;
+         for (int s = 0; s < 5; ++s) {
+            out << "," << stats[s] ;
+         }
+         out << "\n" ;
+      }
+   }
+   if (json) {
+      out << "\n  }\n}\n" ;
+   }
+   return bool(out) ;
+}
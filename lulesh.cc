@@ -154,22 +154,39 @@ Additional BSD Notice
 #include <hpx/algorithm.hpp>
 #include <hpx/execution.hpp>
 #include <hpx/hpx.hpp>
+#include <hpx/include/performance_counters.hpp>
+#include <hpx/include/resource_partitioner.hpp>
 #include <hpx/init.hpp>
+#include <hpx/semaphore.hpp>
+
+#include <hwloc.h>
 
 #include <climits>
 #include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fstream>
 #include <iostream>
+#include <linux/perf_event.h>
+#include <map>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 #include <vector>
 
 #include <algorithm>
+#include <atomic>
 #include <execution>
+#include <mutex>
+#include <new>
 #include <numeric>
+#include <set>
 
 #include "lulesh.h"
 
@@ -177,6 +194,566 @@ Int_t taskSizeLagrangeNodal = 0;
 Int_t taskSizeLagrangeElements = 0;
 Int_t taskSizeCalcConstraints = 0;
 
+// How regions are split into EOS tasks: by element count only, or by
+// estimated cost (elements x rep) so that all EOS chains take similar time
+enum class EOSSplitMode { Size, Cost };
+EOSSplitMode eosSplitMode = EOSSplitMode::Size;
+
+// Submit EOS chains of expensive regions first and with high priority
+bool eosPriority = false;
+
+// Pack small regions of equal rep into combined EOS chunks
+bool eosCoalesce = false;
+
+// Re-chunk the regions every n cycles based on measured EOS chunk times (0: off)
+Int_t eosRebalanceInterval = 0;
+
+// Place chunk k of every phase on worker k mod P (--affinity)
+bool chunkAffinity = false;
+
+// One HPX thread pool per L3 cache domain (--l3-pools); spatially adjacent
+// chunks are grouped and each group runs in the pool of one domain
+std::vector<hpx::threads::thread_pool_base *> l3Pools;
+
+// Separate pool with few threads for the bandwidth-bound nodal phases
+// (--memory-pool-threads); the compute phases use the default pool
+hpx::threads::thread_pool_base *memoryPool = nullptr;
+
+// Invalid pool options found by the resource partitioner callback
+std::string poolSetupError;
+
+// Scheduler mode of every pool, with suspension and idle backoff for
+// --co-tenancy
+hpx::threads::policies::scheduler_mode poolSchedulerMode = hpx::threads::policies::scheduler_mode::default_;
+
+// Optional per-cycle durations of the force and nodal phases (--pool-stats)
+bool poolStats = false;
+std::vector<double> forcePhaseTime;
+std::vector<double> combinePhaseTime;
+std::vector<double> positionPhaseTime;
+double phaseStamp = 0.0;
+
+// Chunk-level dependencies from the nodal phases to the kinematics
+// (--nodal-overlap), optionally with double-buffered nodal state
+bool nodalOverlap = false;
+bool nodalDoubleBuffer = false;
+std::vector<std::pair<Index_t, Index_t>> elemChunkNodeRange;
+hpx::mutex nodalOverlapMutex;
+double lastPositionEnd = 0.0;
+double firstKinematicsStart = 0.0;
+std::vector<double> nodalOverlapTime;
+
+// Start the EOS chain of a chunk as soon as the gradients it needs are done
+// instead of after the whole kinematics phase (--fused-pipeline)
+bool fusedPipeline = false;
+
+// Suspend the other workers of the calling pool between two cycles
+// (--co-tenancy) when the serial section takes longer than suspending and
+// resuming them, with the time spent in the serial sections, suspending and
+// resuming
+bool coTenancy = false;
+hpx::threads::thread_pool_base *suspendedPool = nullptr;
+std::vector<std::size_t> suspendedWorkers;
+double serialStart = 0.0;
+std::vector<double> serialTime;
+std::vector<double> suspendTime;
+std::vector<double> resumeTime;
+double suspendTimeSum = 0.0;
+double resumeTimeSum = 0.0;
+
+// Number of element chunks of the kinematics phase, the range of chunk keys
+Index_t numChunkKeys = 1;
+
+// Element planes per tile of the tiled cycle (--tiles), 0 runs the phases over
+// the whole mesh; the region pieces of each tile for its EOS and constraints
+Index_t tilePlanes = 0;
+std::vector<std::vector<EOSChunk>> tileEOSChunks;
+
+// Small problems run the cycle as a sequence of fork-join phases instead of
+// the task graph (--small-path); auto switches at smallPathElems elements
+enum class SmallPathMode { Auto, Tasks, ForkJoin };
+SmallPathMode smallPathMode = SmallPathMode::Tasks;
+Index_t smallPathElems = 32768;
+bool useForkJoin = false;
+
+// Minimum work of a fork-join task in element updates, less work runs inline
+// (--fork-join-task-work)
+Int8_t forkJoinTaskWork = 4096;
+
+// Optional recording of EOS chain durations (--eos-task-stats)
+bool eosTaskStats = false;
+hpx::mutex eosTaskStatsMutex;
+std::vector<double> eosTaskDurations;
+std::vector<double> eosCycleImbalance;
+std::vector<double> eosPhaseMakespan;
+double eosPhaseStartTime = 0.0;
+
+// Launch the EOS and constraint tasks from one spawner task per region
+// (--tree-spawn), and record how long after the start of these phases their
+// last task starts (--spawn-stats)
+bool treeSpawn = false;
+bool spawnStats = false;
+hpx::mutex spawnStatsMutex;
+double spawnPhaseStart = 0.0;
+double lastTaskStart = 0.0;
+std::vector<double> eosLastTaskStart;
+std::vector<double> constraintLastTaskStart;
+
+// The EOS save tasks reduce the time constraints of their elements into
+// the minima of the domain; --separate-constraints runs them as a phase of
+// their own
+bool separateConstraints = false;
+
+// Lagged time step (--lagged-dt): TimeIncrement uses the constraints of the
+// cycle before the last one, scaled by laggedDtSafety, so that the next cycle
+// starts while the constraint phase of the last one is still running
+Real_t laggedDtSafety = 0.0;
+hpx::future<void> pendingConstraints;
+Real_t laggedDtCourant = 1.0e+20;
+Real_t laggedDtHydro = 1.0e+20;
+Real_t laggedPrevTime = 0.0;
+Real_t laggedPrevDt = 0.0;
+Int_t laggedDtFallbacks = 0;
+
+// Upper bound on the EOS chains of the task graph that hold their scratch
+// buffers at the same time (--max-eos-chains, 0: no limit); a chain takes a
+// slot before its first task allocates and returns it after the save task
+Index_t maxEOSChains = 0;
+std::unique_ptr<hpx::counting_semaphore<>> eosChainSlots;
+
+// Split the element and region loops lazily when workers are idle, down to
+// pieces of this many elements (--lazy-split, 0: fixed task sizes)
+Index_t lazySplitGrain = 0;
+
+// Ensemble runs (--ensemble): several independent instances in this process.
+// The connectivity of the live instances is kept by mesh size, so that
+// instances of the same size share it.
+struct EnsembleConfig {
+    Int_t nx;
+    Int_t numReg;
+    Int_t balance;
+    Int_t cost;
+    Int_t its;
+};
+hpx::mutex ensembleMutex;
+std::map<Index_t, std::weak_ptr<MeshConnectivity>> ensembleMeshes;
+
+// Per-cycle phase times (--phase-times, built with PHASE_TIMERS). The end of
+// each phase is stamped where the cycle moves on to the next one; phases that
+// overlap in a mode are counted into the later one.
+#ifdef PHASE_TIMERS
+std::string phaseTimesFile;
+std::vector<CyclePhaseTimes> phaseTimes;
+double phaseEnd[NumCyclePhases + 1]; // [0]: start of the cycle
+#define PHASE_END(phase) (phaseEnd[(phase) + 1] = WallTime())
+#else
+#define PHASE_END(phase)
+#endif
+
+// Application performance counters (/lulesh/...), set by RunCycle at the end
+// of each cycle of any domain and read by the HPX counter framework, e.g. with
+// --hpx:print-counter=/lulesh/fom --hpx:print-counter-interval=1000
+std::atomic<std::int64_t> counterCycle{0};
+std::atomic<std::int64_t> counterZoneCycles{0}; // elements x cycles since counterFomStart
+std::atomic<double> counterFomStart{0.0};
+std::atomic<std::int64_t> counterTasksPerCycle{0};
+std::atomic<std::int64_t> counterEOSRepWork{0};
+#ifdef PHASE_TIMERS
+std::atomic<std::int64_t> counterPhaseTime[NumCyclePhases] = {}; // ns
+#endif
+
+// Job server (--serve): domains kept for reuse by later jobs of the same
+// mesh size, and the wait between scans of an empty spool directory
+const std::size_t serveCachedDomains = 4;
+const Int_t servePollInterval = 100; // ms
+
+// Hardware counters per kernel (--kernel-counters). Each worker thread opens
+// a perf_event_open group on its first kernel; the group is read at entry and
+// exit of each kernel and the differences are summed per kernel and thread.
+// Kernels do not suspend, so both reads see the counters of the same worker.
+// A kernel called from within another one is counted in the outer one.
+enum Kernel {
+    KernelInitIntegrateStress,
+    KernelCalcHourglass,
+    KernelCombineVolumeForces,
+    KernelCalcAcceleration,
+    KernelAccelerationBoundaryConditions,
+    KernelCalcVelocityAndPosition,
+    KernelCalcKinematics,
+    KernelCalcMonotonicQGradients,
+    KernelCalcMonotonicQRegionAndApplyInit,
+    KernelEvalEOSAllInOne,
+    KernelCalcSoundSpeedAndSave,
+    KernelCalcConstraints,
+    NumKernels
+};
+const char *kernelNames[NumKernels] = {
+    "InitIntegrateStressForElemsTask",
+    "CalcHourglassForElemsTask",
+    "combineVolumeForcesTaskFunc",
+    "CalcAccelerationForNodesTask",
+    "ApplyAccelerationBoundaryConditions",
+    "CalcVelocityAndPositionForNodesTask",
+    "CalcKinematicsForElemsTask",
+    "CalcMonotonicQGradientsForElemsTask",
+    "CalcMonotonicQRegionForElemsAndApplyInitTask",
+    "EvalEOSAllInOneTask",
+    "CalcSoundSpeedForElemsAndSaveTask",
+    "CalcConstraintForElemsTask",
+};
+enum KernelCounter { CounterCycles, CounterInstructions, CounterLLCMisses, CounterDTLBMisses, CounterStalledCycles,
+                     NumKernelCounters };
+
+// Analytic cost of a kernel per element (per node for the nodal kernels),
+// counted from the loop bodies. Bytes are compulsory memory traffic: each
+// array a kernel touches counts once per element for reading and once for
+// writing, however many passes the kernel makes over its chunk; the gathered
+// nodal values of an element count as one node (the rest are reused from
+// cache by its neighbours); a scratch array counts once written and once read
+// wherever that happens. Flops count additions, multiplications, divisions
+// and square roots as one each; sign changes, comparisons, min/max and fabs
+// are free.
+struct KernelCost {
+    double bytes;
+    double flops;
+};
+const KernelCost kernelCosts[NumKernels] = {
+    // InitIntegrateStress
+    //   bytes: p, q 16; sigxx/yy/zz written and read 48; determ written and
+    //          read 16; nodelist 32; x, y, z 24; 24 corner forces 192
+    //   flops: sigma 1; shape derivatives 129 (jacobian 72, cofactors 27,
+    //          derivatives 24, volume 6); node normals 6 faces x 48 = 288;
+    //          corner forces 24
+    {328.0, 442.0},
+    // CalcHourglass
+    //   bytes: nodelist 32; x, y, z 24; xd, yd, zd 24; dvdx/y/z and x8n/y8n/z8n
+    //          (8 corners each) written and read 768; determ written and read 16;
+    //          volo, v 16; ss, elemMass 16; 24 corner forces 192
+    //   flops: volume derivatives 8 x 72 = 576; determ 1; hourglass modes
+    //          4 x 3 x 15 = 180; hourgam 4 x 8 x 7 = 224; volinv, cbrt and
+    //          coefficient 6; hourglass forces 3 x (60 + 64) = 372
+    {1088.0, 1359.0},
+    // CombineVolumeForces (per node)
+    //   bytes: nodeElemCount 4; 8 corner indices 32; 8 corners of the stress
+    //          and hourglass forces 384; fx, fy, fz 24
+    //   flops: 8 corners x 6 additions = 48
+    {444.0, 48.0},
+    // CalcAcceleration (per node)
+    //   bytes: fx, fy, fz, nodalMass 32; xdd, ydd, zdd 24
+    //   flops: 3 divisions
+    {56.0, 3.0},
+    // AccelerationBoundaryConditions (per symmetry plane node)
+    //   bytes: node index 4; xdd, ydd or zdd written 8
+    {12.0, 0.0},
+    // CalcVelocityAndPosition (per node)
+    //   bytes: xd, yd, zd read and written 48; xdd, ydd, zdd 24; x, y, z read
+    //          and written 48
+    //   flops: velocity 3 x 2; position 3 x 2
+    {120.0, 12.0},
+    // CalcKinematics
+    //   bytes: nodelist 32; x, y, z 24; xd, yd, zd 24; volo 8; v read and
+    //          written 16; delv, arealg 16; vnew written and read 16; dxx, dyy,
+    //          dzz written and read 48; vdov 8
+    //   flops: volume 90; relative volume and delv 2; characteristic length
+    //          6 faces x 41 + 3 = 249; half step positions 49; shape
+    //          derivatives 129; velocity gradient 115; deviatoric strain 6;
+    //          volume cut 1
+    {192.0, 641.0},
+    // CalcMonotonicQGradients
+    //   bytes: nodelist 32; x, y, z 24; xd, yd, zd 24; volo, vnew 16;
+    //          delx_* and delv_* written 48
+    //   flops: vol and norm 3; 9 position differences x 8 = 72; 3 directions x
+    //          (cross product 9, delx 8, normalisation 3, velocity
+    //          differences 24, delv 5) = 147
+    {144.0, 222.0},
+    // CalcMonotonicQRegionAndApplyInit
+    //   bytes: regElemList 4; elemBC 4; 6 neighbour indices 24; delv_* 24;
+    //          delx_* 24; vdov, elemMass, volo, vnew 32; qq, ql written to the
+    //          domain and to scratch 32; vnewc_local written and read 16
+    //   flops: 3 limiters x 8 = 24; delvx 3; rho 2; qlin 10; qquad 16
+    {160.0, 55.0},
+    // EvalEOSAllInOne (per repetition)
+    //   bytes: regElemList 4; e, delv, p, q, qq, ql 48; 15 scratch arrays
+    //          (e_old to pHalfStep) written and read 240; vnewc_local 8
+    //   flops: compressions 6; energy init 6; 3 pressures x 3 = 9;
+    //          half step energy and q 21; work 2; full step energy 19;
+    //          final q 9
+    {300.0, 72.0},
+    // CalcSoundSpeedAndSave, with the fused time constraints
+    //   bytes: regElemList 4; pbvc, e_new, vnewc_local, bvc, p_new, q_new 48;
+    //          ss written and read 16; p, e, q written 24; vdov, arealg 16
+    //   flops: sound speed 7; courant constraint 8; hydro constraint 2
+    {108.0, 17.0},
+    // CalcConstraints
+    //   bytes: regElemList 4; ss, vdov, arealg 24
+    //   flops: courant constraint 8; hydro constraint 2
+    {28.0, 10.0},
+};
+
+// Per-kernel data of one worker thread: the counter group and sums over the
+// kernel calls, with the wall time and elements or nodes for --roofline
+struct KernelCounterThread {
+    int fd[NumKernelCounters];    // -1: not supported, fd[CounterCycles] leads the group
+    Int_t numOpen = 0;            // values per group read, in counter order
+    std::uint64_t counts[NumKernels][NumKernelCounters] = {};
+    std::uint64_t calls[NumKernels] = {};
+    double time[NumKernels] = {};
+    std::uint64_t items[NumKernels] = {};
+};
+bool kernelCounters = false;
+bool roofline = false;
+std::mutex kernelCounterMutex; // not an hpx::mutex: the task must not move off the thread it counts
+std::vector<std::unique_ptr<KernelCounterThread>> kernelCounterThreads;
+thread_local KernelCounterThread *kernelCounterThread = nullptr;
+thread_local bool inKernelScope = false;
+
+static int OpenPerfCounter(std::uint32_t type, std::uint64_t config, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = groupFd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+// Kernel data of the calling worker thread, with its counter group opened on
+// first use (--kernel-counters)
+static KernelCounterThread *KernelCountersOfThread() {
+    if (kernelCounterThread != nullptr)
+        return kernelCounterThread;
+    std::unique_ptr<KernelCounterThread> thread = std::make_unique<KernelCounterThread>();
+    std::fill(thread->fd, thread->fd + NumKernelCounters, -1);
+    const std::uint64_t llcMisses = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const std::uint64_t dtlbMisses = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const std::pair<std::uint32_t, std::uint64_t> events[NumKernelCounters] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, llcMisses},
+        {PERF_TYPE_HW_CACHE, dtlbMisses},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+    };
+    for (Int_t c = 0; c < NumKernelCounters && kernelCounters; ++c) {
+        if (c == CounterCycles || thread->fd[CounterCycles] != -1)
+            thread->fd[c] = OpenPerfCounter(events[c].first, events[c].second, thread->fd[CounterCycles]);
+        if (thread->fd[c] != -1)
+            ++thread->numOpen;
+    }
+    if (thread->fd[CounterCycles] != -1)
+        ioctl(thread->fd[CounterCycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+    std::lock_guard<std::mutex> lock(kernelCounterMutex);
+    kernelCounterThreads.push_back(std::move(thread));
+    kernelCounterThread = kernelCounterThreads.back().get();
+    return kernelCounterThread;
+}
+
+// Closes the counter groups of all worker threads, once the kernels are done
+static void CloseKernelCounters() {
+    std::lock_guard<std::mutex> lock(kernelCounterMutex);
+    for (std::unique_ptr<KernelCounterThread> const &thread : kernelCounterThreads) {
+        for (Int_t c = NumKernelCounters - 1; c >= 0; --c) {
+            if (thread->fd[c] != -1)
+                close(thread->fd[c]);
+            thread->fd[c] = -1;
+        }
+        thread->numOpen = 0;
+    }
+}
+
+// Reads the counter group into values, 0 for unsupported counters
+static void ReadKernelCounters(KernelCounterThread *thread, std::uint64_t values[NumKernelCounters]) {
+    std::uint64_t buf[NumKernelCounters + 1];
+    if (read(thread->fd[CounterCycles], buf, sizeof(std::uint64_t) * (thread->numOpen + 1)) <= 0)
+        buf[0] = 0;
+    Int_t next = 1;
+    for (Int_t c = 0; c < NumKernelCounters; ++c)
+        values[c] = (thread->fd[c] != -1 && next <= (Int_t) buf[0]) ? buf[next++] : 0;
+}
+
+// Allocation accounting (--alloc-stats, built with ALLOC_STATS). Allocate and
+// Release and the allocator of the domain's arrays (DomainVector) count into a
+// block of the calling thread, by the kernel running on the thread (set by
+// KernelScope) or the cycle driver outside the kernels, which allocates the
+// corner force and gradient arrays with Allocate. The global operator new is
+// not replaced, so HPX's own allocations (tasks, futures, continuations) are
+// not counted and use the same allocator as in a normal run. RunCycle takes
+// the sums over the threads at the start and end of each cycle; the sums at
+// the start of the first cycle are the setup. Blocks are never freed, since
+// threads may count until exit.
+#ifdef ALLOC_STATS
+enum AllocKind { AllocAllocate, AllocVector, NumAllocKinds };
+const Int_t AllocSiteDriver = NumKernels;
+const Int_t NumAllocSites = NumKernels + 1;
+
+struct AllocThread {
+    std::atomic<std::uint64_t> count[NumAllocSites][NumAllocKinds] = {};
+    std::atomic<std::uint64_t> bytes[NumAllocSites][NumAllocKinds] = {};
+    std::atomic<std::uint64_t> released[NumAllocKinds] = {};
+};
+struct AllocCycle {
+    std::uint64_t count[NumAllocSites][NumAllocKinds] = {};
+    std::uint64_t bytes[NumAllocSites][NumAllocKinds] = {};
+    std::uint64_t released[NumAllocKinds] = {};
+};
+std::atomic<bool> allocStats{false};
+std::mutex allocThreadMutex; // not an hpx::mutex: the count must stay on the calling thread
+std::vector<AllocThread *> allocThreads;
+std::vector<AllocCycle> allocCycles;
+AllocCycle allocCycleStart;
+AllocCycle allocSetup;
+thread_local AllocThread *allocThread = nullptr;
+thread_local Int_t allocSite = AllocSiteDriver;
+
+// Block of the calling thread, registered on first use; nullptr while the
+// accounting is off
+static inline AllocThread *AllocThreadOfCaller() {
+    if (!allocStats.load(std::memory_order_relaxed))
+        return nullptr;
+    if (allocThread == nullptr) {
+        AllocThread *thread = new AllocThread;
+        {
+            std::lock_guard<std::mutex> lock(allocThreadMutex);
+            allocThreads.push_back(thread);
+        }
+        allocThread = thread;
+    }
+    return allocThread;
+}
+
+// Only the owning thread writes its block
+static inline void AddAllocCount(std::atomic<std::uint64_t> &counter, std::uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static inline void CountAlloc(AllocKind kind, std::size_t bytes) {
+    AllocThread *thread = AllocThreadOfCaller();
+    if (thread == nullptr)
+        return;
+    AddAllocCount(thread->count[allocSite][kind], 1);
+    AddAllocCount(thread->bytes[allocSite][kind], bytes);
+}
+
+static inline void CountFree(AllocKind kind) {
+    AllocThread *thread = AllocThreadOfCaller();
+    if (thread != nullptr)
+        AddAllocCount(thread->released[kind], 1);
+}
+
+void CountAllocate(size_t bytes) {
+    CountAlloc(AllocAllocate, bytes);
+}
+
+void CountRelease() {
+    CountFree(AllocAllocate);
+}
+
+void CountVectorAllocate(size_t bytes) {
+    CountAlloc(AllocVector, bytes);
+}
+
+void CountVectorRelease() {
+    CountFree(AllocVector);
+}
+
+// Sums of the counters over all threads
+static AllocCycle AllocTotals() {
+    AllocCycle totals;
+    {
+        std::lock_guard<std::mutex> lock(allocThreadMutex);
+        for (AllocThread const *thread : allocThreads) {
+            for (Int_t site = 0; site < NumAllocSites; ++site) {
+                for (Int_t kind = 0; kind < NumAllocKinds; ++kind) {
+                    totals.count[site][kind] += thread->count[site][kind].load(std::memory_order_relaxed);
+                    totals.bytes[site][kind] += thread->bytes[site][kind].load(std::memory_order_relaxed);
+                }
+            }
+            for (Int_t kind = 0; kind < NumAllocKinds; ++kind)
+                totals.released[kind] += thread->released[kind].load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+// Stores the allocations since the start of the cycle
+static void RecordAllocCycle() {
+    AllocCycle end = AllocTotals();
+    AllocCycle cycle;
+    for (Int_t site = 0; site < NumAllocSites; ++site) {
+        for (Int_t kind = 0; kind < NumAllocKinds; ++kind) {
+            cycle.count[site][kind] = end.count[site][kind] - allocCycleStart.count[site][kind];
+            cycle.bytes[site][kind] = end.bytes[site][kind] - allocCycleStart.bytes[site][kind];
+        }
+    }
+    for (Int_t kind = 0; kind < NumAllocKinds; ++kind)
+        cycle.released[kind] = end.released[kind] - allocCycleStart.released[kind];
+    allocCycles.push_back(cycle);
+}
+#endif
+
+// Counts the hardware events (--kernel-counters) and measures the wall time
+// and the elements or nodes processed (--roofline) of the enclosing kernel
+class KernelScope {
+public:
+    explicit KernelScope(Kernel kernel, Index_t items = 0) : kernel(kernel), items(items) {
+#ifdef ALLOC_STATS
+        outerAllocSite = allocSite;
+        allocSite = kernel;
+#endif
+        if ((!kernelCounters && !roofline) || inKernelScope)
+            return;
+        thread = KernelCountersOfThread();
+        counting = thread->fd[CounterCycles] != -1;
+        if (!counting && !roofline) {
+            thread = nullptr;
+            return;
+        }
+        inKernelScope = true;
+        if (counting)
+            ReadKernelCounters(thread, start);
+        startTime = WallTime();
+    }
+
+    ~KernelScope() {
+#ifdef ALLOC_STATS
+        allocSite = outerAllocSite;
+#endif
+        if (thread == nullptr)
+            return;
+        thread->time[kernel] += WallTime() - startTime;
+        thread->items[kernel] += items;
+        if (counting) {
+            std::uint64_t end[NumKernelCounters];
+            ReadKernelCounters(thread, end);
+            for (Int_t c = 0; c < NumKernelCounters; ++c)
+                thread->counts[kernel][c] += end[c] - start[c];
+        }
+        ++thread->calls[kernel];
+        inKernelScope = false;
+    }
+
+    // For kernels that find their item count while running
+    void AddItems(Index_t n) {
+        items += n;
+    }
+
+private:
+    Kernel kernel;
+    Index_t items;
+    KernelCounterThread *thread = nullptr;
+    bool counting = false;
+    std::uint64_t start[NumKernelCounters];
+    double startTime = 0.0;
+#ifdef ALLOC_STATS
+    Int_t outerAllocSite;
+#endif
+};
+
 /* Work Routines */
 
 static inline void TimeIncrement(Domain &domain) {
@@ -566,6 +1143,8 @@ static inline void CalcElemFBHourglassForce(Real_t *xd, Real_t *yd, Real_t *zd,
 static inline void ApplyAccelerationBoundaryConditionsForNodes(Domain &domain) {
     Index_t size = domain.sizeX();
     Index_t numNodeBC = (size + 1) * (size + 1);
+    KernelScope scope(KernelAccelerationBoundaryConditions,
+                      numNodeBC * (!domain.symmXempty() + !domain.symmYempty() + !domain.symmZempty()));
 
     if (!domain.symmXempty()) {
         hpx::for_each(hpx::execution::seq, domain.symmX_begin(),
@@ -589,6 +1168,27 @@ static inline void ApplyAccelerationBoundaryConditionsForNodes(Domain &domain) {
 
 /******************************************/
 
+// Boundary conditions for the nodes [off, off + numNode) only; the symmetry
+// plane node sets are sorted by node index
+static inline void ApplyAccelerationBoundaryConditionsForNodeRange(Domain &domain, Index_t off, Index_t numNode) {
+    KernelScope scope(KernelAccelerationBoundaryConditions);
+    Index_t size = domain.sizeX();
+    Index_t numNodeBC = (size + 1) * (size + 1);
+    auto apply = [&scope, off, numNode, numNodeBC](Index_t *symm, Real_t *dd) {
+        Index_t *it = std::lower_bound(symm, symm + numNodeBC, off);
+        Index_t *first = it;
+        for (; it != symm + numNodeBC && *it < off + numNode; ++it)
+            dd[*it] = Real_t(0.0);
+        scope.AddItems(it - first);
+    };
+    if (!domain.symmXempty())
+        apply(domain.symmX_begin(), domain.xdd_begin());
+    if (!domain.symmYempty())
+        apply(domain.symmY_begin(), domain.ydd_begin());
+    if (!domain.symmZempty())
+        apply(domain.symmZ_begin(), domain.zdd_begin());
+}
+
 static inline Real_t CalcElemVolume(
         const Real_t x0, const Real_t x1, const Real_t x2, const Real_t x3,
         const Real_t x4, const Real_t x5, const Real_t x6, const Real_t x7,
@@ -786,6 +1386,7 @@ CalcElemVelocityGradient(const Real_t *const xvel, const Real_t *const yvel,
 
 static inline void InitIntegrateStressForElemsTask(Domain &domain, Real_t *fx_elem, Real_t *fy_elem,
                                                    Real_t *fz_elem, Index_t numElem, Index_t off) {
+    KernelScope scope(KernelInitIntegrateStress, numElem);
     // -----------------------------------
     // InitStressTermsForElemsTask (formerly)
     // -----------------------------------
@@ -829,15 +1430,16 @@ static inline void InitIntegrateStressForElemsTask(Domain &domain, Real_t *fx_el
                                     &fx_elem[idx * 8], &fy_elem[idx * 8],
                                     &fz_elem[idx * 8]);
     }
-    free(sigzz);
-    free(sigyy);
-    free(sigxx);
-    free(determ);
+    Release(&sigzz);
+    Release(&sigyy);
+    Release(&sigxx);
+    Release(&determ);
 }
 
 static inline void combineVolumeForcesTaskFunc(Domain &domain, Real_t *fx_elem_stress, Real_t *fy_elem_stress,
                                                Real_t *fz_elem_stress, Real_t *fx_elem_hourglass, Real_t *fy_elem_hourglass,
                                                Real_t *fz_elem_hourglass, Index_t numNode, Index_t off) {
+    KernelScope scope(KernelCombineVolumeForces, numNode);
 
     for (Index_t i = 0; i < numNode; ++i) {
         Index_t gnode = i + off;
@@ -863,6 +1465,7 @@ static inline void combineVolumeForcesTaskFunc(Domain &domain, Real_t *fx_elem_s
 
 static inline void CalcHourglassForElemsTask(Domain &domain, Real_t *fx_elem, Real_t *fy_elem, Real_t *fz_elem,
                                              Real_t hgcoef, Index_t numElem, Index_t off) {
+    KernelScope scope(KernelCalcHourglass, numElem);
 
     // ----------------------------------------
     // CalcHourglassControlForElems (formerly)
@@ -1114,6 +1717,7 @@ static inline void CalcHourglassForElemsTask(Domain &domain, Real_t *fx_elem, Re
 
 static inline void CalcAccelerationForNodesTask(Real_t *fx, Real_t *fy, Real_t *fz, Real_t *xdd, Real_t *ydd,
                                                 Real_t *zdd, Real_t *nodalMass, Index_t numNodes) {
+    KernelScope scope(KernelCalcAcceleration, numNodes);
     for (Index_t i = 0; i < numNodes; ++i) {
         Real_t mass = nodalMass[i];
         xdd[i] = fx[i] / mass;
@@ -1122,9 +1726,44 @@ static inline void CalcAccelerationForNodesTask(Real_t *fx, Real_t *fy, Real_t *
     }
 }
 
+// Variant of CalcVelocityAndPositionForNodesTask that reads the previous
+// nodal state and writes the new one (--nodal-double-buffer)
+static inline void CalcVelocityAndPositionForNodesFromTask(const Real_t *x_old, const Real_t *y_old,
+                                                           const Real_t *z_old, const Real_t *xd_old,
+                                                           const Real_t *yd_old, const Real_t *zd_old,
+                                                           Real_t *x, Real_t *y, Real_t *z, Real_t *xd, Real_t *yd,
+                                                           Real_t *zd, Real_t *xdd, Real_t *ydd, Real_t *zdd,
+                                                           const Real_t dt, const Real_t u_cut, Index_t numNode) {
+    KernelScope scope(KernelCalcVelocityAndPosition, numNode);
+    for (Index_t i = 0; i < numNode; ++i) {
+        Real_t xdnew = xd_old[i] + xdd[i] * dt;
+        if (std::abs(xdnew) < u_cut)
+            xdnew = Real_t(0.0);
+        xd[i] = xdnew;
+    }
+    for (Index_t i = 0; i < numNode; ++i) {
+        Real_t ydnew = yd_old[i] + ydd[i] * dt;
+        if (std::abs(ydnew) < u_cut)
+            ydnew = Real_t(0.0);
+        yd[i] = ydnew;
+    }
+    for (Index_t i = 0; i < numNode; ++i) {
+        Real_t zdnew = zd_old[i] + zdd[i] * dt;
+        if (std::abs(zdnew) < u_cut)
+            zdnew = Real_t(0.0);
+        zd[i] = zdnew;
+    }
+    for (Index_t i = 0; i < numNode; ++i) {
+        x[i] = x_old[i] + xd[i] * dt;
+        y[i] = y_old[i] + yd[i] * dt;
+        z[i] = z_old[i] + zd[i] * dt;
+    }
+}
+
 static inline void CalcVelocityAndPositionForNodesTask(Real_t *x, Real_t *y, Real_t *z, Real_t *xd, Real_t *yd,
                                                        Real_t *zd, Real_t *xdd, Real_t *ydd, Real_t *zdd, const Real_t dt,
                                                        const Real_t u_cut, Index_t numNode) {
+    KernelScope scope(KernelCalcVelocityAndPosition, numNode);
     // -----------------------------
     // CalcVelocityForNodes
     // -----------------------------
@@ -1169,6 +1808,7 @@ struct LagrangeElementsData {
 static inline void CalcKinematicsForElemsTask(Domain &domain, Real_t deltaTime, Real_t *vdov, Real_t *v,
                                               Real_t *vnew, Real_t v_cut, Real_t eosvmin, Real_t eosvmax,
                                               Index_t numElem, Index_t off) {
+    KernelScope scope(KernelCalcKinematics, numElem);
     struct LagrangeElementsData data = {0};
     Real_t *dxx = data.dxx = Allocate<Real_t>(numElem);
     Real_t *dyy = data.dyy = Allocate<Real_t>(numElem);
@@ -1275,6 +1915,7 @@ static inline void CalcKinematicsForElemsTask(Domain &domain, Real_t deltaTime,
 }
 
 static inline void CalcMonotonicQGradientsForElemsTask(Domain &domain, Index_t numElem, Index_t off) {
+    KernelScope scope(KernelCalcMonotonicQGradients, numElem);
 
     for (Index_t i = 0; i < numElem; ++i) {
         Index_t i_off = i + off;
@@ -1420,8 +2061,11 @@ static inline void CalcMonotonicQGradientsForElemsTask(Domain &domain, Index_t n
 static inline struct EvalEOSData CalcMonotonicQRegionForElemsAndApplyInitTask(Domain &domain, Real_t ptiny,
                                                                               Real_t eosvmin, Real_t eosvmax,
                                                                               Index_t *regElemList, Index_t numElemReg) {
+    KernelScope scope(KernelCalcMonotonicQRegionAndApplyInit, numElemReg);
 
     struct EvalEOSData taskData = {0};
+    if (eosTaskStats)
+        taskData.startTime = WallTime();
     taskData.numElemReg = numElemReg;
     taskData.regElemList = regElemList;
     taskData.e_old = Allocate<Real_t>(numElemReg);
@@ -1691,6 +2335,7 @@ static inline void CalcPressureForElemsTask(Real_t *p_new, Real_t *bvc, Real_t *
 
 static inline struct EvalEOSData EvalEOSAllInOneTask(Domain &domain, struct EvalEOSData data, Real_t emin, Real_t pmin,
                                                      Real_t p_cut, Real_t rho0, Real_t e_cut, Real_t q_cut) {
+    KernelScope scope(KernelEvalEOSAllInOne, data.numElemReg);
 
     Index_t numElem = data.numElemReg;
     Index_t *regElemList = data.regElemList;
@@ -1870,7 +2515,46 @@ static inline struct EvalEOSData EvalEOSAllInOneTask(Domain &domain, struct Eval
     return data;
 }
 
+struct ConstraintResults {
+    Real_t dtcourant;
+    Real_t dthydro;
+};
+
+struct ConstraintResults compareConstraintResults(struct ConstraintResults a, struct ConstraintResults b) {
+    struct ConstraintResults r;
+    r.dtcourant = a.dtcourant < b.dtcourant ? a.dtcourant : b.dtcourant;
+    r.dthydro = a.dthydro < b.dthydro ? a.dthydro : b.dthydro;
+    return r;
+}
+
+// Courant and hydro time constraints of one element
+static inline Real_t CalcCourantConstraintForElem(Real_t ss, Real_t vdov, Real_t arealg, Real_t qqc2) {
+    if (vdov == Real_t(0.0))
+        return std::numeric_limits<Real_t>::max();
+    Real_t dtf = ss * ss;
+    if (vdov < Real_t(0.0)) {
+        dtf += qqc2 * arealg * arealg * vdov * vdov;
+    }
+    dtf = std::sqrt(dtf);
+    return arealg / dtf;
+}
+
+static inline Real_t CalcHydroConstraintForElem(Real_t vdov, Real_t dvovmax) {
+    if (vdov == Real_t(0.0))
+        return std::numeric_limits<Real_t>::max();
+    return dvovmax / (std::abs(vdov) + Real_t(1.e-20));
+}
+
+// Lowers the minimum in target to value; the order of the updates does not
+// change the result
+static inline void AtomicMin(std::atomic<Real_t> &target, Real_t value) {
+    Real_t current = target.load(std::memory_order_relaxed);
+    while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
 static inline void CalcSoundSpeedForElemsAndSaveTask(Domain &domain, struct EvalEOSData data, Real_t rho0, Real_t ss403) {
+    KernelScope scope(KernelCalcSoundSpeedAndSave, data.numElemReg);
     Index_t numElem = data.numElemReg;
     Index_t *regElemList = data.regElemList;
     Real_t *enewc = data.e_new;
@@ -1905,6 +2589,22 @@ static inline void CalcSoundSpeedForElemsAndSaveTask(Domain &domain, struct Eval
         domain.q(ielem) = q_new[i];
     }
 
+    // time constraints of the chunk while its ss values are in cache
+    if (!separateConstraints) {
+        Real_t qqc2 = Real_t(64.0) * domain.qqc() * domain.qqc();
+        Real_t dvovmax = domain.dvovmax();
+        Real_t dtcourant = Real_t(1.0e+20);
+        Real_t dthydro = Real_t(1.0e+20);
+        for (Index_t i = 0; i < numElem; ++i) {
+            Index_t ielem = regElemList[i];
+            dtcourant = std::min(dtcourant, CalcCourantConstraintForElem(domain.ss(ielem), domain.vdov(ielem),
+                                                                         domain.arealg(ielem), qqc2));
+            dthydro = std::min(dthydro, CalcHydroConstraintForElem(domain.vdov(ielem), dvovmax));
+        }
+        AtomicMin(domain.cycleDtCourant(), dtcourant);
+        AtomicMin(domain.cycleDtHydro(), dthydro);
+    }
+
     Release(&data.e_old);
     Release(&data.delvc);
     Release(&data.p_old);
@@ -1923,20 +2623,9 @@ static inline void CalcSoundSpeedForElemsAndSaveTask(Domain &domain, struct Eval
     Release(&data.vnewc_local);
 }
 
-struct ConstraintResults {
-    Real_t dtcourant;
-    Real_t dthydro;
-};
-
-struct ConstraintResults compareConstraintResults(struct ConstraintResults a, struct ConstraintResults b) {
-    struct ConstraintResults r;
-    r.dtcourant = a.dtcourant < b.dtcourant ? a.dtcourant : b.dtcourant;
-    r.dthydro = a.dthydro < b.dthydro ? a.dthydro : b.dthydro;
-    return r;
-}
-
 static inline struct ConstraintResults CalcConstraintForElemsTask(Domain &domain, Index_t length, Index_t *regElemlist,
                                                                   Real_t qqc, Real_t dtcourant, Real_t dvovmax, Real_t dthydro) {
+    KernelScope scope(KernelCalcConstraints, length);
 
     Real_t qqc2 = Real_t(64.0) * qqc * qqc;
     dtcourant = hpx::transform_reduce(
@@ -1944,18 +2633,7 @@ static inline struct ConstraintResults CalcConstraintForElemsTask(Domain &domain
             dtcourant, [](Real_t a, Real_t b) { return a < b ? a : b; },
             [&](Index_t i) {
                 Index_t indx = regElemlist[i];
-                if (domain.vdov(indx) == Real_t(0.0)) {
-                    return std::numeric_limits<Real_t>::max();
-                } else {
-                    Real_t dtf = domain.ss(indx) * domain.ss(indx);
-                    if (domain.vdov(indx) < Real_t(0.0)) {
-                        dtf += qqc2 * domain.arealg(indx) * domain.arealg(indx) *
-                               domain.vdov(indx) * domain.vdov(indx);
-                    }
-                    dtf = std::sqrt(dtf);
-                    dtf = domain.arealg(indx) / dtf;
-                    return dtf;
-                }
+                return CalcCourantConstraintForElem(domain.ss(indx), domain.vdov(indx), domain.arealg(indx), qqc2);
             });
 
     dthydro = hpx::transform_reduce(
@@ -1963,16 +2641,610 @@ static inline struct ConstraintResults CalcConstraintForElemsTask(Domain &domain
             dthydro, [](Real_t a, Real_t b) { return a < b ? a : b; },
             [&](Index_t i) {
                 Index_t indx = regElemlist[i];
-                if (domain.vdov(indx) == Real_t(0.0)) {
-                    return std::numeric_limits<Real_t>::max();
-                } else {
-                    return dvovmax / (std::abs(domain.vdov(indx)) + Real_t(1.e-20));
-                }
+                return CalcHydroConstraintForElem(domain.vdov(indx), dvovmax);
             });
 
     return {dtcourant, dthydro};
 }
 
+/******************************************/
+
+// Number of EOS evaluations per element of a region (artificial load imbalance)
+static inline Int_t CalcRegionRep(Domain &domain, Int_t reg) {
+    // Determine load imbalance for this region
+    // round down the number with lowest cost
+    if (reg < domain.numReg() / 2)
+        return 1;
+    // you don't get an expensive region unless you at least have 5 regions
+    else if (reg < (domain.numReg() - (domain.numReg() + 15) / 20))
+        return 1 + domain.cost();
+    // very expensive regions
+    else
+        return 10 * (1 + domain.cost());
+}
+
+// Number of EOS tasks a region is split into. In cost mode, a chunk of a
+// region with rep repetitions gets 1/rep of the elements of a cheap chunk.
+static inline Int_t CalcRegionEOSTasks(Index_t numElemReg, Int_t rep) {
+    Int8_t costPerElem = (eosSplitMode == EOSSplitMode::Cost) ? rep : 1;
+    Int8_t costReg = costPerElem * numElemReg;
+    Int8_t n_tasks = costReg / taskSizeLagrangeElements;
+    if (n_tasks == 0)
+        n_tasks = 1;
+    else if (costReg - n_tasks * taskSizeLagrangeElements >
+             (Int8_t) (0.3 * taskSizeLagrangeElements))
+        ++n_tasks;
+    // at least one element per task
+    if (n_tasks > numElemReg && numElemReg > 0)
+        n_tasks = numElemReg;
+    return (Int_t) n_tasks;
+}
+
+// Packs consecutive regions with the same rep that cost less than one task
+// into combined chunks of about one task of cost. A combined chunk works over
+// the concatenated element lists of its regions, so the regions share one
+// task chain and one EvalEOSData allocation.
+static void CoalesceEOSChunks(Domain &domain) {
+    std::vector<EOSChunk> &chunks = domain.eosChunks();
+    std::vector<std::vector<Index_t>> &lists = domain.eosCoalescedLists();
+    lists.clear();
+    auto cost = [](const EOSChunk &c) {
+        return (Int8_t) c.numElem * ((eosSplitMode == EOSSplitMode::Cost) ? c.rep : 1);
+    };
+    auto isSmall = [&](const EOSChunk &c) {
+        return c.numElem == domain.regElemSize(c.reg) && cost(c) < taskSizeLagrangeElements;
+    };
+
+    std::vector<EOSChunk> coalesced;
+    std::size_t first = 0;
+    while (first < chunks.size()) {
+        std::size_t last = first + 1;
+        if (isSmall(chunks[first])) {
+            Int8_t costSum = cost(chunks[first]);
+            while (last < chunks.size() && costSum < taskSizeLagrangeElements &&
+                   chunks[last].rep == chunks[first].rep && isSmall(chunks[last])) {
+                costSum += cost(chunks[last]);
+                ++last;
+            }
+        }
+        if (last - first == 1) {
+            coalesced.push_back(chunks[first]);
+        } else {
+            std::vector<Index_t> list;
+            for (std::size_t c = first; c < last; ++c)
+                list.insert(list.end(), chunks[c].regElemList, chunks[c].regElemList + chunks[c].numElem);
+            lists.push_back(std::move(list));
+            coalesced.push_back({-1, chunks[first].rep, lists.back().data(), (Index_t) lists.back().size(), 0.0});
+        }
+        first = last;
+    }
+    chunks.swap(coalesced);
+}
+
+// Static decomposition of all regions into EOS chunks based on the rep model
+static void BuildEOSChunks(Domain &domain) {
+    std::vector<EOSChunk> &chunks = domain.eosChunks();
+    chunks.clear();
+    for (Int_t reg = 0; reg < domain.numReg(); ++reg) {
+        Index_t numElemReg = domain.regElemSize(reg);
+        Index_t *regElemList = domain.regElemlist(reg);
+        Int_t rep = CalcRegionRep(domain, reg);
+
+        // calculate elements per task for this region
+        Int_t n_tasks = CalcRegionEOSTasks(numElemReg, rep);
+        Int_t elemsPerTaskReg = numElemReg / n_tasks;
+
+        for (Int_t task = 0; task < n_tasks; ++task) {
+            Index_t numElemsThis = (task == n_tasks - 1) ? (numElemReg -
+                                                            task * elemsPerTaskReg)
+                                                         : elemsPerTaskReg;
+            chunks.push_back({reg, rep, &regElemList[task * elemsPerTaskReg], numElemsThis, 0.0});
+        }
+    }
+    // the regions only change with the chunks, so the EOS work per cycle of
+    // the counters is summed here
+    domain.eosRepWork() = 0;
+    for (Int_t reg = 0; reg < domain.numReg(); ++reg)
+        domain.eosRepWork() += (Int8_t) domain.regElemSize(reg) * CalcRegionRep(domain, reg);
+    if (eosCoalesce)
+        CoalesceEOSChunks(domain);
+}
+
+// Moves the chunk boundaries inside each region's element list so that all
+// chunks have the same measured cost. The cost per element is assumed to be
+// constant within each chunk of the sampled cycle. The total number of chunks
+// is kept; regions receive chunks in proportion to their measured time.
+static void RebalanceEOSChunks(Domain &domain) {
+    std::vector<EOSChunk> &chunks = domain.eosChunks();
+    double total = 0.0;
+    for (const EOSChunk &chunk : chunks)
+        total += chunk.measuredTime;
+    if (total <= 0.0)
+        return;
+    double target = total / chunks.size();
+
+    std::vector<EOSChunk> rebalanced;
+    rebalanced.reserve(chunks.size());
+    std::size_t first = 0;
+    while (first < chunks.size()) {
+        // coalesced chunks of small regions are kept as they are
+        if (chunks[first].reg < 0) {
+            rebalanced.push_back(chunks[first]);
+            rebalanced.back().measuredTime = 0.0;
+            ++first;
+            continue;
+        }
+        // chunks of a region are stored consecutively
+        Int_t reg = chunks[first].reg;
+        Int_t rep = chunks[first].rep;
+        std::size_t last = first;
+        double regTime = 0.0;
+        while (last < chunks.size() && chunks[last].reg == reg) {
+            regTime += chunks[last].measuredTime;
+            ++last;
+        }
+        Index_t numElemReg = domain.regElemSize(reg);
+        Index_t *regElemList = domain.regElemlist(reg);
+        Index_t n_tasks = std::min<Index_t>(numElemReg, std::lround(regTime / target));
+        if (n_tasks < 1)
+            n_tasks = 1;
+
+        // place boundary k where the accumulated cost reaches k * regTime / n_tasks
+        double perTask = regTime / n_tasks;
+        std::vector<Index_t> bounds(1, 0);
+        double acc = 0.0;
+        Index_t k = 1;
+        for (std::size_t c = first; c < last; ++c) {
+            Index_t chunkBegin = chunks[c].regElemList - regElemList;
+            double t = chunks[c].measuredTime;
+            double perElem = chunks[c].numElem > 0 ? t / chunks[c].numElem : 0.0;
+            while (k < n_tasks && acc + t >= k * perTask) {
+                Index_t pos = chunkBegin + (perElem > 0.0 ? (Index_t) ((k * perTask - acc) / perElem) : 0);
+                if (pos > bounds.back() && pos < numElemReg)
+                    bounds.push_back(pos);
+                ++k;
+            }
+            acc += t;
+        }
+        bounds.push_back(numElemReg);
+
+        for (std::size_t b = 0; b + 1 < bounds.size(); ++b) {
+            rebalanced.push_back({reg, rep, &regElemList[bounds[b]], bounds[b + 1] - bounds[b], 0.0});
+        }
+        first = last;
+    }
+    chunks.swap(rebalanced);
+}
+
+// Start of a phase whose last task start is recorded (--spawn-stats)
+static void BeginSpawnPhase() {
+    spawnPhaseStart = WallTime();
+    lastTaskStart = spawnPhaseStart;
+}
+
+// Called by each task of that phase when it starts
+static void RecordTaskStart() {
+    double now = WallTime();
+    std::lock_guard<hpx::mutex> lock(spawnStatsMutex);
+    lastTaskStart = std::max(lastTaskStart, now);
+}
+
+// Launches the EOS task chain of one chunk: monotonic Q and EOS init, rep EOS
+// evaluations, sound speed and save. In sample cycles the work time of the
+// chain is stored in the chunk.
+static hpx::future<void> LaunchEOSChain(Domain &domain, EOSChunk &chunk,
+                                        hpx::execution::parallel_executor exec, bool sample) {
+    const Real_t ptiny = Real_t(1.e-36);
+    Real_t eosvmin = domain.eosvmin();
+    Real_t eosvmax = domain.eosvmax();
+    Real_t e_cut = domain.e_cut();
+    Real_t p_cut = domain.p_cut();
+    Real_t q_cut = domain.q_cut();
+    Real_t ss4o3 = domain.ss4o3();
+    Real_t pmin = domain.pmin();
+    Real_t emin = domain.emin();
+    Real_t rho0 = domain.refdens();
+    EOSChunk *c = &chunk;
+
+    hpx::future<struct EvalEOSData> f = hpx::async(exec, [&domain, c, ptiny, eosvmin, eosvmax, sample]() {
+        if (spawnStats)
+            RecordTaskStart();
+        if (eosChainSlots)
+            eosChainSlots->acquire();
+        double t0 = sample ? WallTime() : 0.0;
+        struct EvalEOSData data = CalcMonotonicQRegionForElemsAndApplyInitTask(domain, ptiny, eosvmin, eosvmax,
+                                                                              c->regElemList, c->numElem);
+        if (sample)
+            data.workTime = WallTime() - t0;
+        return data;
+    });
+    for (Int_t r = 0; r < chunk.rep; ++r) {
+        f = f.then(exec, [&domain, emin, pmin, p_cut, rho0, e_cut, q_cut, sample](hpx::future<struct EvalEOSData> &&f_move) {
+            double t0 = sample ? WallTime() : 0.0;
+            struct EvalEOSData data = EvalEOSAllInOneTask(domain, f_move.get(), emin, pmin, p_cut, rho0, e_cut, q_cut);
+            if (sample)
+                data.workTime += WallTime() - t0;
+            return data;
+        });
+    }
+    return f.then(exec, [&domain, c, rho0, ss4o3, sample](hpx::future<struct EvalEOSData> &&f_move) {
+        double t0 = sample ? WallTime() : 0.0;
+        struct EvalEOSData data = f_move.get();
+        double startTime = data.startTime;
+        double workTime = data.workTime;
+        CalcSoundSpeedForElemsAndSaveTask(domain, data, rho0, ss4o3);
+        if (eosChainSlots)
+            eosChainSlots->release();
+        if (sample)
+            c->measuredTime = workTime + (WallTime() - t0);
+        if (eosTaskStats) {
+            double duration = WallTime() - startTime;
+            std::lock_guard<hpx::mutex> lock(eosTaskStatsMutex);
+            eosTaskDurations.push_back(duration);
+        }
+    });
+}
+
+// Executor for the task of chunk k. With --affinity, chunk k is placed on
+// worker k mod P in every phase and cycle, so it finds its data in that
+// worker's cache; other workers only steal it when they run out of work.
+// With --l3-pools, the chunk keys are split into contiguous groups, one per
+// L3 domain, and the task runs in the pool of its group (worker k mod P
+// within the pool with --affinity).
+static inline hpx::execution::parallel_executor ChunkExecutor(
+        Index_t k, hpx::threads::thread_priority priority = hpx::threads::thread_priority::default_) {
+    if (!l3Pools.empty()) {
+        std::size_t group = std::min<std::size_t>(l3Pools.size() - 1, (Int8_t) k * l3Pools.size() / numChunkKeys);
+        hpx::threads::thread_pool_base *pool = l3Pools[group];
+        if (!chunkAffinity)
+            return hpx::execution::parallel_executor(pool, priority);
+        std::int16_t worker = static_cast<std::int16_t>(k % pool->get_os_thread_count());
+        return hpx::execution::parallel_executor(pool, priority, hpx::threads::thread_stacksize::default_,
+                                                 hpx::threads::thread_schedule_hint(worker));
+    }
+    if (!chunkAffinity)
+        return hpx::execution::parallel_executor(priority);
+    std::int16_t worker = static_cast<std::int16_t>(k % hpx::get_num_worker_threads());
+    return hpx::execution::parallel_executor(priority, hpx::threads::thread_stacksize::default_,
+                                             hpx::threads::thread_schedule_hint(worker));
+}
+
+// Chunk index of a range starting at element off: its element chunk in the
+// kinematics phase, so all element phases agree on the placement
+static inline Index_t ElemChunkKey(Index_t off) {
+    return off / taskSizeLagrangeElements;
+}
+
+// Number of element chunks, the range of chunk keys, of a domain
+static inline Index_t NumChunkKeys(Index_t numElem) {
+    return std::max<Index_t>(1, (numElem + taskSizeLagrangeElements - 1) / taskSizeLagrangeElements);
+}
+
+// Nodes and elements are both numbered plane by plane; node off lies in about
+// the same plane as element off * numElem / numNode
+static inline Index_t NodeChunkKey(Domain &domain, Index_t off) {
+    return ElemChunkKey((Index_t) ((Int8_t) off * domain.numElem() / domain.numNode()));
+}
+
+// Executor for the node chunk starting at node off: the memory pool if there
+// is one, otherwise the executor of its chunk key
+static inline hpx::execution::parallel_executor NodeChunkExecutor(Domain &domain, Index_t off) {
+    if (memoryPool == nullptr)
+        return ChunkExecutor(NodeChunkKey(domain, off));
+    if (!chunkAffinity)
+        return hpx::execution::parallel_executor(memoryPool);
+    std::int16_t worker = static_cast<std::int16_t>(NodeChunkKey(domain, off) % memoryPool->get_os_thread_count());
+    return hpx::execution::parallel_executor(memoryPool, hpx::threads::thread_priority::default_,
+                                             hpx::threads::thread_stacksize::default_,
+                                             hpx::threads::thread_schedule_hint(worker));
+}
+
+// Suspends all workers of the calling thread's pool but the calling one, so
+// that they do not spin while other jobs share the node
+static void SuspendWorkers() {
+    if (!suspendedWorkers.empty())
+        return;
+    double t0 = WallTime();
+    suspendedPool = hpx::this_thread::get_pool();
+    std::size_t self = hpx::get_local_worker_thread_num();
+    std::vector<hpx::future<void>> futs;
+    for (std::size_t i = 0; i < suspendedPool->get_os_thread_count(); ++i) {
+        if (i == self)
+            continue;
+        futs.push_back(hpx::threads::suspend_processing_unit(*suspendedPool, i));
+        suspendedWorkers.push_back(i);
+    }
+    if (suspendedWorkers.empty())
+        return;
+    hpx::wait_all(futs);
+    suspendTime.push_back(WallTime() - t0);
+    suspendTimeSum += suspendTime.back();
+}
+
+// Resumes the workers suspended by SuspendWorkers before a parallel phase
+static void ResumeWorkers() {
+    if (suspendedWorkers.empty())
+        return;
+    double t0 = WallTime();
+    std::vector<hpx::future<void>> futs;
+    for (std::size_t i : suspendedWorkers)
+        futs.push_back(hpx::threads::resume_processing_unit(*suspendedPool, i));
+    hpx::wait_all(futs);
+    suspendedWorkers.clear();
+    resumeTime.push_back(WallTime() - t0);
+    resumeTimeSum += resumeTime.back();
+}
+
+// Start of the serial section between two cycles (--co-tenancy). The workers
+// are suspended in the first one, which measures the cost, and afterwards only
+// if the last serial section took longer than suspending and resuming them on
+// average.
+static void BeginSerialSection() {
+    if (!coTenancy)
+        return;
+    bool suspend = suspendTime.empty() ||
+                   serialTime.back() > suspendTimeSum / suspendTime.size() + resumeTimeSum / resumeTime.size();
+    serialStart = WallTime();
+    if (suspend)
+        SuspendWorkers();
+}
+
+// End of that serial section: resumes the workers and records its length
+// without the time spent suspending and resuming
+static void EndSerialSection() {
+    if (!coTenancy || serialStart == 0.0)
+        return;
+    bool suspended = !suspendedWorkers.empty();
+    ResumeWorkers();
+    double elapsed = WallTime() - serialStart;
+    if (suspended)
+        elapsed -= suspendTime.back() + resumeTime.back();
+    serialTime.push_back(elapsed);
+    serialStart = 0.0;
+}
+
+// Cheap check for work to steal: the queue of the calling worker holds no
+// waiting HPX thread, so a worker that runs out of work finds nothing here.
+// Only this worker's queue is read.
+static inline bool LocalQueueEmpty(hpx::threads::thread_pool_base *pool, std::size_t worker) {
+    return pool->get_thread_count(hpx::threads::thread_schedule_state::pending,
+                                  hpx::threads::thread_priority::default_, worker, false) == 0;
+}
+
+// Processes the range [off, off + num) in pieces of grain elements. Before each
+// piece, if the worker's queue is empty, the upper half of the remaining range
+// is split off as a new task on that queue, where idle workers steal it (lazy
+// binary splitting). Waits for the split off tasks.
+template <typename F>
+static void LazySplitTask(F body, Index_t num, Index_t off, Index_t grain) {
+    std::vector<hpx::future<void>> splits;
+    Index_t end = off + num;
+    while (off < end) {
+        Index_t remaining = end - off;
+        hpx::threads::thread_pool_base *pool = hpx::this_thread::get_pool();
+        std::size_t worker = hpx::get_local_worker_thread_num();
+        if (remaining >= 2 * grain && LocalQueueEmpty(pool, worker)) {
+            Index_t mid = end - remaining / 2;
+            hpx::execution::parallel_executor exec(pool, hpx::threads::thread_priority::default_,
+                                                   hpx::threads::thread_stacksize::default_,
+                                                   hpx::threads::thread_schedule_hint(static_cast<std::int16_t>(worker)));
+            splits.push_back(hpx::async(exec, [body, mid, end, grain]() {
+                LazySplitTask(body, end - mid, mid, grain);
+            }));
+            end = mid;
+            continue;
+        }
+        Index_t numThis = std::min(grain, remaining);
+        body(numThis, off);
+        off += numThis;
+    }
+    hpx::wait_all(splits);
+}
+
+// Starts one lazily splitting task per worker thread for a loop over num elements
+template <typename F>
+static void LaunchLazySplitTasks(std::vector<hpx::future<void>> &fut_vec, Index_t num, F body) {
+    Index_t numTasks = std::max<Index_t>(1, std::min<Index_t>(hpx::get_num_worker_threads(), num / lazySplitGrain));
+    Index_t off = 0;
+    for (Index_t t = 0; t < numTasks; ++t) {
+        Index_t numThis = num / numTasks + (t < num % numTasks ? 1 : 0);
+        fut_vec.push_back(hpx::async(ChunkExecutor(ElemChunkKey(off)), [body, numThis, off]() {
+            LazySplitTask(body, numThis, off, lazySplitGrain);
+        }));
+        off += numThis;
+    }
+}
+
+// Runs the whole EOS chain of a piece of a region within the calling task
+static void RunEOSChain(Domain &domain, Int_t rep, Index_t *regElemList, Index_t numElem) {
+    const Real_t ptiny = Real_t(1.e-36);
+    if (spawnStats)
+        RecordTaskStart();
+    double startTime = eosTaskStats ? WallTime() : 0.0;
+    struct EvalEOSData data = CalcMonotonicQRegionForElemsAndApplyInitTask(domain, ptiny, domain.eosvmin(),
+                                                                          domain.eosvmax(), regElemList, numElem);
+    for (Int_t r = 0; r < rep; ++r) {
+        data = EvalEOSAllInOneTask(domain, data, domain.emin(), domain.pmin(), domain.p_cut(), domain.refdens(),
+                                   domain.e_cut(), domain.q_cut());
+    }
+    CalcSoundSpeedForElemsAndSaveTask(domain, data, domain.refdens(), domain.ss4o3());
+    if (eosTaskStats) {
+        double duration = WallTime() - startTime;
+        std::lock_guard<hpx::mutex> lock(eosTaskStatsMutex);
+        eosTaskDurations.push_back(duration);
+    }
+}
+
+// Lowest and highest node index read by each element chunk of the kinematics
+// phase; the connectivity is fixed, so this is computed once
+static void BuildElemChunkNodeRanges(Domain &domain) {
+    elemChunkNodeRange.clear();
+    for (Index_t off = 0; off < domain.numElem(); off += taskSizeLagrangeElements) {
+        Index_t end = std::min(off + taskSizeLagrangeElements, domain.numElem());
+        Index_t *nodes = domain.nodelist(off);
+        auto range = std::minmax_element(nodes, nodes + 8 * (end - off));
+        elemChunkNodeRange.push_back({*range.first, *range.second});
+    }
+}
+
+// Nodal phases and kinematics with chunk-level dependencies (--nodal-overlap).
+// Each node chunk runs force combination, acceleration, boundary conditions and
+// velocity/position update on its own; the kinematics and gradients of an
+// element chunk start as soon as the node chunks holding its nodes are final.
+// With --nodal-double-buffer the update reads the previous nodal state and
+// writes the current one. Frees the element force arrays.
+static std::vector<hpx::future<void>> LaunchOverlappedNodalPhases(
+        Domain &domain, Real_t *fx_elem_stress, Real_t *fy_elem_stress, Real_t *fz_elem_stress,
+        Real_t *fx_elem_hourglass, Real_t *fy_elem_hourglass, Real_t *fz_elem_hourglass) {
+    Index_t numNode = domain.numNode();
+    Index_t numElem = domain.numElem();
+    const Real_t delt = domain.deltatime();
+    Real_t u_cut = domain.u_cut();
+    Real_t v_cut = domain.v_cut();
+    Real_t eosvmin = domain.eosvmin();
+    Real_t eosvmax = domain.eosvmax();
+
+    if (elemChunkNodeRange.empty())
+        BuildElemChunkNodeRanges(domain);
+    if (nodalDoubleBuffer)
+        domain.SwapNodalBuffers();
+    if (poolStats) {
+        lastPositionEnd = 0.0;
+        firstKinematicsStart = std::numeric_limits<double>::max();
+    }
+
+    std::vector<hpx::shared_future<void>> position_fut_vec;
+    for (Index_t off = 0; off < numNode; off += taskSizeLagrangeNodal) {
+        Index_t numNodeThis = std::min(taskSizeLagrangeNodal, numNode - off);
+        position_fut_vec.push_back(hpx::async(NodeChunkExecutor(domain, off), [=, &domain]() {
+            combineVolumeForcesTaskFunc(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress, fx_elem_hourglass,
+                                        fy_elem_hourglass, fz_elem_hourglass, numNodeThis, off);
+            CalcAccelerationForNodesTask(&domain.fx(off), &domain.fy(off), &domain.fz(off), &domain.xdd(off),
+                                         &domain.ydd(off), &domain.zdd(off), &domain.nodalMass(off), numNodeThis);
+            ApplyAccelerationBoundaryConditionsForNodeRange(domain, off, numNodeThis);
+            if (nodalDoubleBuffer) {
+                CalcVelocityAndPositionForNodesFromTask(
+                        &domain.x_prev_begin()[off], &domain.y_prev_begin()[off], &domain.z_prev_begin()[off],
+                        &domain.xd_prev_begin()[off], &domain.yd_prev_begin()[off], &domain.zd_prev_begin()[off],
+                        &domain.x(off), &domain.y(off), &domain.z(off), &domain.xd(off), &domain.yd(off),
+                        &domain.zd(off), &domain.xdd(off), &domain.ydd(off), &domain.zdd(off), delt, u_cut,
+                        numNodeThis);
+            } else {
+                CalcVelocityAndPositionForNodesTask(&domain.x(off), &domain.y(off), &domain.z(off), &domain.xd(off),
+                                                    &domain.yd(off), &domain.zd(off), &domain.xdd(off),
+                                                    &domain.ydd(off), &domain.zdd(off), delt, u_cut, numNodeThis);
+            }
+            if (poolStats) {
+                double now = WallTime();
+                std::lock_guard<hpx::mutex> lock(nodalOverlapMutex);
+                lastPositionEnd = std::max(lastPositionEnd, now);
+            }
+        }));
+    }
+
+    std::vector<hpx::future<void>> f_vec_lagrange;
+    for (Index_t off = 0; off < numElem; off += taskSizeLagrangeElements) {
+        Index_t numElemThis = std::min(taskSizeLagrangeElements, numElem - off);
+        const std::pair<Index_t, Index_t> &range = elemChunkNodeRange[off / taskSizeLagrangeElements];
+        std::vector<hpx::shared_future<void>> deps(position_fut_vec.begin() + range.first / taskSizeLagrangeNodal,
+                                                   position_fut_vec.begin() + range.second / taskSizeLagrangeNodal + 1);
+        f_vec_lagrange.push_back(hpx::when_all(deps).then(ChunkExecutor(ElemChunkKey(off)), [=, &domain](auto &&) {
+            if (poolStats) {
+                double now = WallTime();
+                std::lock_guard<hpx::mutex> lock(nodalOverlapMutex);
+                firstKinematicsStart = std::min(firstKinematicsStart, now);
+            }
+            CalcKinematicsForElemsTask(domain, delt, &domain.vdov(off), &domain.v(off), &domain.vnew(off),
+                                       v_cut, eosvmin, eosvmax, numElemThis, off);
+            CalcMonotonicQGradientsForElemsTask(domain, numElemThis, off);
+        }));
+    }
+
+    f_vec_lagrange.push_back(hpx::when_all(position_fut_vec).then([=](auto &&) mutable {
+        Release(&fz_elem_hourglass);
+        Release(&fy_elem_hourglass);
+        Release(&fx_elem_hourglass);
+        Release(&fz_elem_stress);
+        Release(&fy_elem_stress);
+        Release(&fx_elem_stress);
+    }));
+    return f_vec_lagrange;
+}
+
+// Gradient blocks (element chunks of the kinematics phase) needed by the
+// monotonic Q of an EOS chunk: the blocks of its elements and of their face
+// neighbours, which are at most one element plane away
+static std::vector<hpx::shared_future<void>> GradientDeps(Domain &domain, const EOSChunk &chunk,
+                                                          std::vector<hpx::shared_future<void>> const &gradients) {
+    if (chunk.numElem == 0)
+        return {};
+    auto range = std::minmax_element(chunk.regElemList, chunk.regElemList + chunk.numElem);
+    Index_t plane = domain.sizeX() * domain.sizeY();
+    Index_t first = std::max<Index_t>(0, *range.first - plane) / taskSizeLagrangeElements;
+    Index_t last = std::min<Index_t>(domain.numElem() - 1, *range.second + plane) / taskSizeLagrangeElements;
+    return std::vector<hpx::shared_future<void>>(gradients.begin() + first, gradients.begin() + last + 1);
+}
+
+// Launches the EOS chain of a chunk, after the gradient blocks it needs if
+// they are given (--fused-pipeline)
+static hpx::future<void> LaunchEOSChunk(Domain &domain, EOSChunk &chunk,
+                                        std::vector<hpx::shared_future<void>> const &gradients, bool sample) {
+    // the chunk follows the element chunk of its first element
+    hpx::execution::parallel_executor exec = ChunkExecutor(
+            chunk.numElem > 0 ? ElemChunkKey(chunk.regElemList[0]) : 0,
+            (eosPriority && chunk.rep > 1) ? hpx::threads::thread_priority::high : hpx::threads::thread_priority::default_);
+    if (gradients.empty())
+        return LaunchEOSChain(domain, chunk, exec, sample);
+    EOSChunk *c = &chunk;
+    return hpx::when_all(GradientDeps(domain, chunk, gradients)).then(
+            exec, [&domain, c, exec, sample](auto &&) { return LaunchEOSChain(domain, *c, exec, sample); });
+}
+
+// Launches the constraint tasks of region r
+static void LaunchConstraintTasks(Domain &domain, Index_t r, Real_t qqc, Real_t dtcourant, Real_t dvomax,
+                                  Real_t dthydro, std::vector<hpx::future<struct ConstraintResults>> &tasks) {
+    Index_t reg_off = 0;
+    Index_t numElemReg = domain.regElemSize(r);
+    Index_t *regElemList = domain.regElemlist(r);
+    while (reg_off < numElemReg) {
+        Index_t *regElemListThis = &regElemList[reg_off];
+        Index_t elems = std::min(taskSizeCalcConstraints, numElemReg - reg_off);
+        tasks.push_back(hpx::async(ChunkExecutor(ElemChunkKey(regElemListThis[0])),
+                                   [&domain, elems, regElemListThis, qqc, dtcourant, dvomax, dthydro]() {
+            if (spawnStats)
+                RecordTaskStart();
+            return CalcConstraintForElemsTask(domain, elems, regElemListThis, qqc, dtcourant, dvomax, dthydro);
+        }));
+        reg_off += elems;
+    }
+}
+
+// Waits for the constraints of the last cycle (--lagged-dt) and checks the dt
+// of this cycle against them: if it is larger than the dt computed from them,
+// the time increment is redone synchronously with that dt
+static void ResolveLaggedDt(Domain &domain) {
+    if (!pendingConstraints.valid())
+        return;
+    pendingConstraints.get();
+    Real_t laggedTime = domain.time();
+    Real_t laggedDt = domain.deltatime();
+    domain.time() = laggedPrevTime;
+    domain.deltatime() = laggedPrevDt;
+    domain.dtcourant() = laggedDtCourant;
+    domain.dthydro() = laggedDtHydro;
+    --domain.cycle();
+    TimeIncrement(domain);
+    if (laggedDt <= domain.deltatime()) {
+        domain.time() = laggedTime;
+        domain.deltatime() = laggedDt;
+    } else {
+        ++laggedDtFallbacks;
+    }
+    // input of the next time increment
+    domain.dtcourant() = laggedDtSafety * laggedDtCourant;
+    domain.dthydro() = laggedDtSafety * laggedDtHydro;
+}
+
 /******************************************/
 static inline void LagrangeLeapFrogWithTasks(Domain &domain) {
 
@@ -1994,22 +3266,17 @@ static inline void LagrangeLeapFrogWithTasks(Domain &domain) {
     Real_t *zdd = domain.zdd_begin();
 
     Real_t hgcoef = domain.hgcoef();
-    const Real_t delt = domain.deltatime();
     Real_t u_cut = domain.u_cut();
-    Real_t deltaTime = domain.deltatime();
     Real_t v_cut = domain.v_cut();
     Real_t eosvmin = domain.eosvmin();
     Real_t eosvmax = domain.eosvmax();
 
-    const Real_t ptiny = Real_t(1.e-36);
-    Real_t e_cut = domain.e_cut();
-    Real_t p_cut = domain.p_cut();
-    Real_t ss4o3 = domain.ss4o3();
-    Real_t q_cut = domain.q_cut();
+    // first EOS chain sample of this cycle (no EOS task is running yet)
+    std::size_t eosStatsBegin = eosTaskDurations.size();
+    double cycleStart = poolStats ? WallTime() : 0.0;
 
-    Real_t pmin = domain.pmin();
-    Real_t emin = domain.emin();
-    Real_t rho0 = domain.refdens();
+    // end of the serial section between two cycles
+    EndSerialSection();
 
     // ----------------------------------
     // CalcForceForNodes
@@ -2023,120 +3290,175 @@ static inline void LagrangeLeapFrogWithTasks(Domain &domain) {
 
     // Index_t num_tasks = numElem / elemsPerTask;
     std::vector<hpx::future<void>> calc_forces_fut_vec;
-    Index_t off = 0;
-    while (off < numElem) {
-        Index_t numElemsThis = std::min(taskSizeLagrangeNodal, numElem - off);
-        calc_forces_fut_vec.push_back(hpx::async(InitIntegrateStressForElemsTask, std::ref(domain), fx_elem_stress,
-                                                 fy_elem_stress, fz_elem_stress, numElemsThis, off));
-
-        Real_t *fx_tmp = &fx_elem_hourglass[off * 8];
-        Real_t *fy_tmp = &fy_elem_hourglass[off * 8];
-        Real_t *fz_tmp = &fz_elem_hourglass[off * 8];
-        calc_forces_fut_vec.push_back(hpx::async(CalcHourglassForElemsTask, std::ref(domain), fx_tmp,
-                                                 fy_tmp, fz_tmp, hgcoef, numElemsThis, off));
-        off += numElemsThis;
-    }
-
-    hpx::future<std::vector<hpx::future<void>>> force_for_nodes_fut = hpx::when_all(calc_forces_fut_vec).then(
-            [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
-        std::vector<hpx::future<void>> combine_forces_fut_vec;
-        Real_t *fx = domain.fx_begin();
-        Real_t *fy = domain.fy_begin();
-        Real_t *fz = domain.fz_begin();
-        Real_t *nodalMass = domain.nodalMass_begin();
-        Index_t off = 0;
-        while (off < numNode) {
-            Index_t numNodeThis = std::min(taskSizeLagrangeNodal, numNode - off);
-            auto *fx_this = &fx[off];
-            auto *fy_this = &fy[off];
-            auto *fz_this = &fz[off];
-            auto *xdd_this = &xdd[off];
-            auto *ydd_this = &ydd[off];
-            auto *zdd_this = &zdd[off];
-            auto nodalMass_this = &nodalMass[off];
-            combine_forces_fut_vec.push_back(hpx::async(combineVolumeForcesTaskFunc, std::ref(domain),
-                                                        fx_elem_stress, fy_elem_stress, fz_elem_stress,
-                                                        fx_elem_hourglass, fy_elem_hourglass,
-                                                        fz_elem_hourglass, numNodeThis, off)
-                                                     .then([=](hpx::future<void> &&f_move) {
-                                                         CalcAccelerationForNodesTask(fx_this, fy_this,
-                                                                                      fz_this, xdd_this,
-                                                                                      ydd_this, zdd_this,
-                                                                                      nodalMass_this,
-                                                                                      numNodeThis);
-                                                     }));
-            off += numNodeThis;
-        }
-        return combine_forces_fut_vec;
-    });
-
-    hpx::future<std::vector<hpx::future<void>>> my_fut_2 = hpx::when_all(force_for_nodes_fut.get()).then(
-            [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
-        free(fz_elem_hourglass);
-        free(fy_elem_hourglass);
-        free(fx_elem_hourglass);
-        free(fz_elem_stress);
-        free(fy_elem_stress);
-        free(fx_elem_stress);
-
-        // ----------------------------------
-        // ApplyAccelerationBoundaryConditionForNodes
-        // ----------------------------------
-        ApplyAccelerationBoundaryConditionsForNodes(domain);
-
-        // ----------------------------------
-        // CalcVelocityForNodes
-        // CalcPositionForNodes
-        // ----------------------------------
-        std::vector<hpx::future<void>> calc_position_fut_vec;
-        Index_t off = 0;
-        while (off < numNode) {
-            Index_t numNodeThis = std::min(taskSizeLagrangeNodal, numNode - off);
-            auto *x_this = &x[off];
-            auto *y_this = &y[off];
-            auto *z_this = &z[off];
-            auto *xd_this = &xd[off];
-            auto *yd_this = &yd[off];
-            auto *zd_this = &zd[off];
-            auto *xdd_this = &xdd[off];
-            auto *ydd_this = &ydd[off];
-            auto *zdd_this = &zdd[off];
-            calc_position_fut_vec.push_back(hpx::async(CalcVelocityAndPositionForNodesTask, x_this, y_this, z_this,
-                                                       xd_this, yd_this, zd_this, xdd_this, ydd_this, zdd_this,
-                                                       delt, u_cut, numNodeThis));
-            off += numNodeThis;
-        }
-        return calc_position_fut_vec;
-    });
-
-    hpx::future<std::vector<hpx::future<void>>> lagrange_elem_fut = hpx::when_all(my_fut_2.get()).then(
-            [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
-        // ----------------------------------
-        // LagrangeElements
-        // ----------------------------------
-        domain.AllocateGradients(numElem, allElem);
-
-        std::vector<hpx::future<void>> f_vec_lagrange;
-        std::vector<hpx::future<void>> update_volume_fut_vec;
+    if (lazySplitGrain > 0) {
+        LaunchLazySplitTasks(calc_forces_fut_vec, numElem, [=, &domain](Index_t numElemsThis, Index_t off) {
+            InitIntegrateStressForElemsTask(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress, numElemsThis, off);
+            CalcHourglassForElemsTask(domain, &fx_elem_hourglass[off * 8], &fy_elem_hourglass[off * 8],
+                                      &fz_elem_hourglass[off * 8], hgcoef, numElemsThis, off);
+        });
+    } else {
         Index_t off = 0;
         while (off < numElem) {
-            Index_t numElemThis = std::min(taskSizeLagrangeElements, numElem - off);
-            Real_t *vdov_this = &domain.vdov_begin()[off];
-            Real_t *v_this = &domain.v_begin()[off];
-            Real_t *vnew_this = &domain.vnew_begin()[off];
-            hpx::future<void> sf = hpx::async(
-                    CalcKinematicsForElemsTask, std::ref(domain), deltaTime, vdov_this, v_this, vnew_this,
-                    v_cut, eosvmin, eosvmax, numElemThis, off);
-            f_vec_lagrange.push_back(sf.then([&domain, numElemThis, off](hpx::shared_future<void> &&f_move) {
-                CalcMonotonicQGradientsForElemsTask(domain, numElemThis, off);
-            }));
-            off += numElemThis;
+            Index_t numElemsThis = std::min(taskSizeLagrangeNodal, numElem - off);
+            hpx::execution::parallel_executor exec = ChunkExecutor(ElemChunkKey(off));
+            calc_forces_fut_vec.push_back(hpx::async(exec, InitIntegrateStressForElemsTask, std::ref(domain), fx_elem_stress,
+                                                     fy_elem_stress, fz_elem_stress, numElemsThis, off));
+
+            Real_t *fx_tmp = &fx_elem_hourglass[off * 8];
+            Real_t *fy_tmp = &fy_elem_hourglass[off * 8];
+            Real_t *fz_tmp = &fz_elem_hourglass[off * 8];
+            calc_forces_fut_vec.push_back(hpx::async(exec, CalcHourglassForElemsTask, std::ref(domain), fx_tmp,
+                                                     fy_tmp, fz_tmp, hgcoef, numElemsThis, off));
+            off += numElemsThis;
         }
-        return f_vec_lagrange;
-    });
+    }
 
-    hpx::future<std::vector<hpx::future<void>>> apply_mat_props_fut = hpx::when_all(lagrange_elem_fut.get()).then(
-            [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
+    // the force phase does not depend on dt; with --lagged-dt it runs while
+    // the dt of this cycle is checked against the constraints of the last one
+    ResolveLaggedDt(domain);
+    const Real_t delt = domain.deltatime();
+    Real_t deltaTime = domain.deltatime();
+
+    hpx::future<std::vector<hpx::future<void>>> lagrange_elem_fut;
+    if (nodalOverlap) {
+        lagrange_elem_fut = hpx::when_all(calc_forces_fut_vec).then(
+                [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
+            if (poolStats)
+                forcePhaseTime.push_back(WallTime() - cycleStart);
+            PHASE_END(PhaseForces);
+            PHASE_END(PhaseNodal);
+            domain.AllocateGradients(numElem, allElem);
+            return LaunchOverlappedNodalPhases(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress,
+                                               fx_elem_hourglass, fy_elem_hourglass, fz_elem_hourglass);
+        });
+    } else {
+        hpx::future<std::vector<hpx::future<void>>> force_for_nodes_fut = hpx::when_all(calc_forces_fut_vec).then(
+                [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
+            if (poolStats) {
+                phaseStamp = WallTime();
+                forcePhaseTime.push_back(phaseStamp - cycleStart);
+            }
+            PHASE_END(PhaseForces);
+            std::vector<hpx::future<void>> combine_forces_fut_vec;
+            Real_t *fx = domain.fx_begin();
+            Real_t *fy = domain.fy_begin();
+            Real_t *fz = domain.fz_begin();
+            Real_t *nodalMass = domain.nodalMass_begin();
+            Index_t off = 0;
+            while (off < numNode) {
+                Index_t numNodeThis = std::min(taskSizeLagrangeNodal, numNode - off);
+                auto *fx_this = &fx[off];
+                auto *fy_this = &fy[off];
+                auto *fz_this = &fz[off];
+                auto *xdd_this = &xdd[off];
+                auto *ydd_this = &ydd[off];
+                auto *zdd_this = &zdd[off];
+                auto nodalMass_this = &nodalMass[off];
+                hpx::execution::parallel_executor exec = NodeChunkExecutor(domain, off);
+                combine_forces_fut_vec.push_back(hpx::async(exec, combineVolumeForcesTaskFunc, std::ref(domain),
+                                                            fx_elem_stress, fy_elem_stress, fz_elem_stress,
+                                                            fx_elem_hourglass, fy_elem_hourglass,
+                                                            fz_elem_hourglass, numNodeThis, off)
+                                                         .then(exec, [=](hpx::future<void> &&f_move) {
+                                                             CalcAccelerationForNodesTask(fx_this, fy_this,
+                                                                                          fz_this, xdd_this,
+                                                                                          ydd_this, zdd_this,
+                                                                                          nodalMass_this,
+                                                                                          numNodeThis);
+                                                         }));
+                off += numNodeThis;
+            }
+            return combine_forces_fut_vec;
+        });
+
+        hpx::future<std::vector<hpx::future<void>>> my_fut_2 = hpx::when_all(force_for_nodes_fut.get()).then(
+                [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) mutable {
+            if (poolStats) {
+                double now = WallTime();
+                combinePhaseTime.push_back(now - phaseStamp);
+                phaseStamp = now;
+            }
+            Release(&fz_elem_hourglass);
+            Release(&fy_elem_hourglass);
+            Release(&fx_elem_hourglass);
+            Release(&fz_elem_stress);
+            Release(&fy_elem_stress);
+            Release(&fx_elem_stress);
+
+            // ----------------------------------
+            // ApplyAccelerationBoundaryConditionForNodes
+            // ----------------------------------
+            ApplyAccelerationBoundaryConditionsForNodes(domain);
+
+            // ----------------------------------
+            // CalcVelocityForNodes
+            // CalcPositionForNodes
+            // ----------------------------------
+            std::vector<hpx::future<void>> calc_position_fut_vec;
+            Index_t off = 0;
+            while (off < numNode) {
+                Index_t numNodeThis = std::min(taskSizeLagrangeNodal, numNode - off);
+                auto *x_this = &x[off];
+                auto *y_this = &y[off];
+                auto *z_this = &z[off];
+                auto *xd_this = &xd[off];
+                auto *yd_this = &yd[off];
+                auto *zd_this = &zd[off];
+                auto *xdd_this = &xdd[off];
+                auto *ydd_this = &ydd[off];
+                auto *zdd_this = &zdd[off];
+                calc_position_fut_vec.push_back(hpx::async(NodeChunkExecutor(domain, off),
+                                                           CalcVelocityAndPositionForNodesTask, x_this, y_this, z_this,
+                                                           xd_this, yd_this, zd_this, xdd_this, ydd_this, zdd_this,
+                                                           delt, u_cut, numNodeThis));
+                off += numNodeThis;
+            }
+            return calc_position_fut_vec;
+        });
+
+        lagrange_elem_fut = hpx::when_all(my_fut_2.get()).then(
+                [=, &domain](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
+            if (poolStats)
+                positionPhaseTime.push_back(WallTime() - phaseStamp);
+            PHASE_END(PhaseNodal);
+
+            // ----------------------------------
+            // LagrangeElements
+            // ----------------------------------
+            domain.AllocateGradients(numElem, allElem);
+
+            std::vector<hpx::future<void>> f_vec_lagrange;
+            std::vector<hpx::future<void>> update_volume_fut_vec;
+            if (lazySplitGrain > 0) {
+                LaunchLazySplitTasks(f_vec_lagrange, numElem, [=, &domain](Index_t numElemThis, Index_t off) {
+                    CalcKinematicsForElemsTask(domain, deltaTime, &domain.vdov_begin()[off], &domain.v_begin()[off],
+                                               &domain.vnew_begin()[off], v_cut, eosvmin, eosvmax, numElemThis, off);
+                    CalcMonotonicQGradientsForElemsTask(domain, numElemThis, off);
+                });
+                return f_vec_lagrange;
+            }
+            Index_t off = 0;
+            while (off < numElem) {
+                Index_t numElemThis = std::min(taskSizeLagrangeElements, numElem - off);
+                Real_t *vdov_this = &domain.vdov_begin()[off];
+                Real_t *v_this = &domain.v_begin()[off];
+                Real_t *vnew_this = &domain.vnew_begin()[off];
+                hpx::execution::parallel_executor exec = ChunkExecutor(ElemChunkKey(off));
+                hpx::future<void> sf = hpx::async(
+                        exec, CalcKinematicsForElemsTask, std::ref(domain), deltaTime, vdov_this, v_this, vnew_this,
+                        v_cut, eosvmin, eosvmax, numElemThis, off);
+                f_vec_lagrange.push_back(sf.then(exec, [&domain, numElemThis, off](hpx::shared_future<void> &&f_move) {
+                    CalcMonotonicQGradientsForElemsTask(domain, numElemThis, off);
+                }));
+                off += numElemThis;
+            }
+            return f_vec_lagrange;
+        });
+    }
+
+    // Launches the EOS phase. Given the gradient futures of the element chunks,
+    // each EOS chain waits only for the blocks it needs (--fused-pipeline).
+    auto apply_mat_props = [=, &domain](std::vector<hpx::shared_future<void>> const &gradients) {
         // -------------------------------------
         // ApplyMaterialPropertiesForElemsTask
         // -------------------------------------
@@ -2153,90 +3475,1115 @@ static inline void LagrangeLeapFrogWithTasks(Domain &domain) {
         //      off += elems;
         //    }
 
-        for (Int_t reg = 0; reg < domain.numReg(); ++reg) {
-            Index_t numElemReg = domain.regElemSize(reg);
-            Index_t *regElemList = domain.regElemlist(reg);
-            Int_t rep;
-            // Determine load imbalance for this region
-            // round down the number with lowest cost
-            if (reg < domain.numReg() / 2)
-                rep = 1;
-            // you don't get an expensive region unless you at least have 5 regions
-            else if (reg < (domain.numReg() - (domain.numReg() + 15) / 20))
-                rep = 1 + domain.cost();
-            // very expensive regions
-            else
-                rep = 10 * (1 + domain.cost());
-
-            // calculate elements per task for this region
-            Int_t n_tasks = numElemReg / taskSizeLagrangeElements;
-            if (n_tasks == 0)
-                n_tasks = 1;
-            else if (numElemReg - n_tasks * taskSizeLagrangeElements >
-                     (Int_t) (0.3 * taskSizeLagrangeElements))
-                ++n_tasks;
-            Int_t elemsPerTaskReg = numElemReg / n_tasks;
-
-            for (Int_t task = 0; task < n_tasks; ++task) {
-                Index_t numElemsThis = (task == n_tasks - 1) ? (numElemReg -
-                                                                task * elemsPerTaskReg)
-                                                             : elemsPerTaskReg;
-                Index_t *regElemListThis = &regElemList[task * elemsPerTaskReg];
-
-
-                hpx::future<struct EvalEOSData> f = hpx::async(
-                        CalcMonotonicQRegionForElemsAndApplyInitTask, std::ref(domain), ptiny, eosvmin, eosvmax,
-                        regElemListThis, numElemsThis);
-                for (Int_t r = 0; r < rep; ++r) {
-                    f = f.then([&domain, emin, pmin, p_cut, rho0, e_cut, q_cut](hpx::future<struct EvalEOSData> &&f_move) {
-                        return EvalEOSAllInOneTask(domain, f_move.get(), emin, pmin, p_cut, rho0, e_cut, q_cut);
-                    });
-                }
-                eval_eos_fut_vec.push_back(f.then([&domain, rho0, ss4o3](
-                                                          hpx::future<struct EvalEOSData> &&f_move) {
-                    CalcSoundSpeedForElemsAndSaveTask(domain, f_move.get(), rho0, ss4o3);
+        if (nodalOverlap && poolStats)
+            nodalOverlapTime.push_back(std::max(0.0, lastPositionEnd - firstKinematicsStart));
+        PHASE_END(PhaseKinematics);
+        if (eosTaskStats)
+            eosPhaseStartTime = WallTime();
+        if (spawnStats)
+            BeginSpawnPhase();
+
+        // The most expensive regions have the highest indices. With --eos-priority
+        // their long chains are submitted first with high priority, so that they
+        // do not start last and set the tail of the phase; the chains of cheap
+        // regions fill the remaining gaps.
+        if (lazySplitGrain > 0) {
+            // one task per region, split lazily; pieces hold about the same
+            // work as lazySplitGrain elements evaluated once
+            for (Index_t i = 0; i < domain.numReg(); ++i) {
+                Index_t r = eosPriority ? domain.numReg() - 1 - i : i;
+                Index_t numElemReg = domain.regElemSize(r);
+                if (numElemReg == 0)
+                    continue;
+                Index_t *regElemList = domain.regElemlist(r);
+                Int_t rep = CalcRegionRep(domain, r);
+                Index_t grain = std::max<Index_t>(1, lazySplitGrain / rep);
+                hpx::execution::parallel_executor exec = ChunkExecutor(
+                        ElemChunkKey(regElemList[0]),
+                        (eosPriority && rep > 1) ? hpx::threads::thread_priority::high : hpx::threads::thread_priority::default_);
+                eval_eos_fut_vec.push_back(hpx::async(exec, [&domain, regElemList, numElemReg, rep, grain]() {
+                    LazySplitTask([&domain, regElemList, rep](Index_t numElemThis, Index_t off) {
+                        RunEOSChain(domain, rep, &regElemList[off], numElemThis);
+                    }, numElemReg, 0, grain);
                 }));
             }
+            return eval_eos_fut_vec;
+        }
+        std::vector<EOSChunk> &chunks = domain.eosChunks();
+        bool sample = eosRebalanceInterval > 0 && domain.cycle() % eosRebalanceInterval == 0;
+        if (!treeSpawn) {
+            for (std::size_t i = 0; i < chunks.size(); ++i)
+                eval_eos_fut_vec.push_back(
+                        LaunchEOSChunk(domain, chunks[eosPriority ? chunks.size() - 1 - i : i], gradients, sample));
+            return eval_eos_fut_vec;
+        }
+        // one high priority spawner task per run of chunks of the same
+        // region (or of coalesced regions) launches the chains of its chunks
+        std::vector<std::pair<std::size_t, std::size_t>> groups;
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            if (i == 0 || chunks[i].reg != chunks[i - 1].reg)
+                groups.push_back({i, i});
+            groups.back().second = i + 1;
+        }
+        for (std::size_t g = 0; g < groups.size(); ++g) {
+            std::pair<std::size_t, std::size_t> group = groups[eosPriority ? groups.size() - 1 - g : g];
+            EOSChunk &head = chunks[group.first];
+            hpx::execution::parallel_executor exec = ChunkExecutor(
+                    head.numElem > 0 ? ElemChunkKey(head.regElemList[0]) : 0, hpx::threads::thread_priority::high);
+            eval_eos_fut_vec.push_back(hpx::async(exec, [&domain, &chunks, group, gradients, sample]() {
+                std::vector<hpx::future<void>> futs;
+                for (std::size_t i = 0; i < group.second - group.first; ++i)
+                    futs.push_back(LaunchEOSChunk(
+                            domain, chunks[eosPriority ? group.second - 1 - i : group.first + i], gradients, sample));
+                return hpx::when_all(futs).then([](auto &&) {});
+            }));
         }
         return eval_eos_fut_vec;
-    });
+    };
+
+    hpx::future<std::vector<hpx::future<void>>> apply_mat_props_fut;
+    if (fusedPipeline && lazySplitGrain == 0) {
+        apply_mat_props_fut = lagrange_elem_fut.then(
+                [apply_mat_props](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
+            std::vector<hpx::future<void>> f_vec = f_move.get();
+            std::vector<hpx::shared_future<void>> gradients(std::make_move_iterator(f_vec.begin()),
+                                                            std::make_move_iterator(f_vec.end()));
+            std::vector<hpx::future<void>> eval_eos_fut_vec = apply_mat_props(gradients);
+            // the gradients are released after the EOS phase, so all blocks must be done
+            eval_eos_fut_vec.push_back(hpx::when_all(gradients).then([](auto &&) {}));
+            return eval_eos_fut_vec;
+        });
+    } else {
+        apply_mat_props_fut = hpx::when_all(lagrange_elem_fut.get()).then(
+                [apply_mat_props](hpx::future<std::vector<hpx::future<void>>> &&f_move) {
+            return apply_mat_props({});
+        });
+    }
 
     hpx::future<std::vector<hpx::future<void>>> time_constraints_fut = hpx::when_all(apply_mat_props_fut.get()).then(
-            [&domain](auto &&f_move) {
+            [&domain, eosStatsBegin](auto &&f_move) {
+        PHASE_END(PhaseEOS);
         domain.DeallocateGradients();
+        if (spawnStats) {
+            eosLastTaskStart.push_back(lastTaskStart - spawnPhaseStart);
+            BeginSpawnPhase();
+        }
+
+        if (eosRebalanceInterval > 0 && domain.cycle() % eosRebalanceInterval == 0)
+            RebalanceEOSChunks(domain);
+
+        if (eosTaskStats) {
+            eosPhaseMakespan.push_back(WallTime() - eosPhaseStartTime);
+
+            // imbalance of this cycle's EOS chains: longest vs. average chain
+            Index_t n = eosTaskDurations.size() - eosStatsBegin;
+            double sum = 0.0;
+            double max = 0.0;
+            for (std::size_t i = eosStatsBegin; i < eosTaskDurations.size(); ++i) {
+                sum += eosTaskDurations[i];
+                max = std::max(max, eosTaskDurations[i]);
+            }
+            if (n > 0 && sum > 0.0)
+                eosCycleImbalance.push_back(max * n / sum);
+        }
 
         // ----------------------------------
         // CalcTimeConstraintsForElems
         // ----------------------------------
-        Real_t dtcourant = domain.dtcourant() = 1.0e+20;
-        Real_t dthydro = domain.dthydro() = 1.0e+20;
+        std::vector<hpx::future<void>> fut_vec;
+        if (!separateConstraints) {
+            // already reduced by the EOS save tasks
+            domain.dtcourant() = domain.cycleDtCourant();
+            domain.dthydro() = domain.cycleDtHydro();
+            return fut_vec;
+        }
+        Real_t dtcourant = 1.0e+20;
+        Real_t dthydro = 1.0e+20;
+        // with --lagged-dt they hold the input of the next time increment
+        if (laggedDtSafety == 0.0) {
+            domain.dtcourant() = dtcourant;
+            domain.dthydro() = dthydro;
+        }
         Real_t qqc = domain.qqc();
         Real_t dvomax = domain.dvovmax();
         std::vector<hpx::future<struct ConstraintResults>> constraintTasks;
-        std::vector<hpx::future<void>> fut_vec;
         for (Index_t r = 0; r < domain.numReg(); ++r) {
-            Index_t reg_off = 0;
-            Index_t numElemReg = domain.regElemSize(r);
-            Index_t *regElemList = domain.regElemlist(r);
-            while (reg_off < numElemReg) {
-                Index_t *regElemListThis = &regElemList[reg_off];
-                Index_t elems = std::min(taskSizeCalcConstraints, numElemReg - reg_off);
-                constraintTasks.push_back(hpx::async(CalcConstraintForElemsTask, std::ref(domain), elems, regElemListThis,
-                                                     qqc, dtcourant, dvomax, dthydro));
-                reg_off += elems;
+            if (!treeSpawn) {
+                LaunchConstraintTasks(domain, r, qqc, dtcourant, dvomax, dthydro, constraintTasks);
+            } else if (domain.regElemSize(r) > 0) {
+                // spawner task of the region, returns the reduced result of its tasks
+                constraintTasks.push_back(hpx::async(
+                        ChunkExecutor(ElemChunkKey(domain.regElemlist(r)[0]), hpx::threads::thread_priority::high),
+                        [&domain, r, qqc, dtcourant, dvomax, dthydro]() {
+                    std::vector<hpx::future<struct ConstraintResults>> tasks;
+                    LaunchConstraintTasks(domain, r, qqc, dtcourant, dvomax, dthydro, tasks);
+                    return hpx::when_all(tasks).then(
+                            [dtcourant, dthydro](hpx::future<std::vector<hpx::future<struct ConstraintResults>>> &&f_vec) {
+                        std::vector<struct ConstraintResults> vec = hpx::unwrap_all(f_vec);
+                        struct ConstraintResults init = {dtcourant, dthydro};
+                        return hpx::reduce(hpx::execution::seq, vec.begin(), vec.end(), init, compareConstraintResults);
+                    });
+                }));
             }
         }
         fut_vec.push_back(hpx::when_all(constraintTasks).then(
                 [&domain, dtcourant, dthydro](hpx::future<std::vector<hpx::future<struct ConstraintResults>>> &&f_vec) {
+            if (spawnStats)
+                constraintLastTaskStart.push_back(lastTaskStart - spawnPhaseStart);
             std::vector<struct ConstraintResults> vec = hpx::unwrap_all(f_vec);
             struct ConstraintResults init = {dtcourant, dthydro};
             struct ConstraintResults final = hpx::reduce(hpx::execution::seq, vec.begin(), vec.end(), init, compareConstraintResults);
-            domain.dtcourant() = final.dtcourant;
-            domain.dthydro() = final.dthydro;
+            if (laggedDtSafety > 0.0) {
+                laggedDtCourant = final.dtcourant;
+                laggedDtHydro = final.dthydro;
+            } else {
+                domain.dtcourant() = final.dtcourant;
+                domain.dthydro() = final.dthydro;
+            }
         }));
         return fut_vec;
     });
-    hpx::wait_all(time_constraints_fut.get());
+    std::vector<hpx::future<void>> constraints_fut_vec = time_constraints_fut.get();
+    if (laggedDtSafety > 0.0)
+        pendingConstraints = hpx::when_all(constraints_fut_vec).then([](auto &&) {});
+    else
+        hpx::wait_all(constraints_fut_vec);
+
+    // serial until the next cycle starts: loop control and TimeIncrement
+    BeginSerialSection();
+}
+
+/******************************************/
+
+// Number of tasks for a fork-join phase of the given work: one per
+// forkJoinTaskWork element updates, at most one per worker
+static inline Index_t ForkJoinTasks(Int8_t work) {
+    return (Index_t) std::max<Int8_t>(1, std::min<Int8_t>(hpx::get_num_worker_threads(), work / forkJoinTaskWork));
+}
+
+// Runs body(numThis, off) over [0, num) in ForkJoinTasks(num * weight) parts.
+// One part is run by the calling thread, a single part runs inline.
+template <typename F>
+static void ForkJoinLoop(Index_t num, Int8_t weight, F body) {
+    Index_t numTasks = std::min<Index_t>(ForkJoinTasks(num * weight), std::max<Index_t>(num, 1));
+    std::vector<hpx::future<void>> futs;
+    futs.reserve(numTasks - 1);
+    Index_t off = 0;
+    for (Index_t t = 0; t < numTasks; ++t) {
+        Index_t numThis = num / numTasks + (t < num % numTasks ? 1 : 0);
+        if (t < numTasks - 1)
+            futs.push_back(hpx::async(ChunkExecutor((Int8_t) t * numChunkKeys / numTasks), [&body, numThis, off]() {
+                body(numThis, off);
+            }));
+        else
+            body(numThis, off);
+        off += numThis;
+    }
+    hpx::wait_all(futs);
+}
+
+// Fork-join variant of LagrangeLeapFrogWithTasks for small problems, where
+// task creation and when_all joins dominate. The phases run one after the
+// other, each inline or in a few coarse tasks (--small-path).
+static void LagrangeLeapFrogForkJoin(Domain &domain) {
+    Index_t numNode = domain.numNode();
+    Index_t numElem = domain.numElem();
+    Int_t allElem = numElem +                             /* local elem */
+                    2 * domain.sizeX() * domain.sizeY() + /* plane ghosts */
+                    2 * domain.sizeX() * domain.sizeZ() + /* row ghosts */
+                    2 * domain.sizeY() * domain.sizeZ();  /* col ghosts */
+    Index_t numElem8 = numElem * 8;
+    Real_t hgcoef = domain.hgcoef();
+    const Real_t delt = domain.deltatime();
+    Real_t u_cut = domain.u_cut();
+    Real_t v_cut = domain.v_cut();
+    Real_t eosvmin = domain.eosvmin();
+    Real_t eosvmax = domain.eosvmax();
+    double stamp = poolStats ? WallTime() : 0.0;
+
+    // ----------------------------------
+    // CalcForceForNodes
+    // ----------------------------------
+    Real_t *fx_elem_stress = Allocate<Real_t>(numElem8);
+    Real_t *fy_elem_stress = Allocate<Real_t>(numElem8);
+    Real_t *fz_elem_stress = Allocate<Real_t>(numElem8);
+    Real_t *fx_elem_hourglass = Allocate<Real_t>(numElem8);
+    Real_t *fy_elem_hourglass = Allocate<Real_t>(numElem8);
+    Real_t *fz_elem_hourglass = Allocate<Real_t>(numElem8);
+
+    ForkJoinLoop(numElem, 2, [&](Index_t numElemThis, Index_t off) {
+        InitIntegrateStressForElemsTask(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress, numElemThis, off);
+        CalcHourglassForElemsTask(domain, &fx_elem_hourglass[off * 8], &fy_elem_hourglass[off * 8],
+                                  &fz_elem_hourglass[off * 8], hgcoef, numElemThis, off);
+    });
+    if (poolStats) {
+        forcePhaseTime.push_back(WallTime() - stamp);
+        stamp = WallTime();
+    }
+    PHASE_END(PhaseForces);
+    ForkJoinLoop(numNode, 1, [&](Index_t numNodeThis, Index_t off) {
+        combineVolumeForcesTaskFunc(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress, fx_elem_hourglass,
+                                    fy_elem_hourglass, fz_elem_hourglass, numNodeThis, off);
+        CalcAccelerationForNodesTask(&domain.fx(off), &domain.fy(off), &domain.fz(off), &domain.xdd(off),
+                                     &domain.ydd(off), &domain.zdd(off), &domain.nodalMass(off), numNodeThis);
+    });
+    if (poolStats) {
+        combinePhaseTime.push_back(WallTime() - stamp);
+        stamp = WallTime();
+    }
+
+    Release(&fz_elem_hourglass);
+    Release(&fy_elem_hourglass);
+    Release(&fx_elem_hourglass);
+    Release(&fz_elem_stress);
+    Release(&fy_elem_stress);
+    Release(&fx_elem_stress);
+
+    // ----------------------------------
+    // ApplyAccelerationBoundaryConditionForNodes
+    // CalcVelocityForNodes
+    // CalcPositionForNodes
+    // ----------------------------------
+    ApplyAccelerationBoundaryConditionsForNodes(domain);
+    ForkJoinLoop(numNode, 1, [&](Index_t numNodeThis, Index_t off) {
+        CalcVelocityAndPositionForNodesTask(&domain.x(off), &domain.y(off), &domain.z(off), &domain.xd(off),
+                                            &domain.yd(off), &domain.zd(off), &domain.xdd(off), &domain.ydd(off),
+                                            &domain.zdd(off), delt, u_cut, numNodeThis);
+    });
+    if (poolStats)
+        positionPhaseTime.push_back(WallTime() - stamp);
+    PHASE_END(PhaseNodal);
+
+    // ----------------------------------
+    // LagrangeElements
+    // ----------------------------------
+    domain.AllocateGradients(numElem, allElem);
+    ForkJoinLoop(numElem, 2, [&](Index_t numElemThis, Index_t off) {
+        CalcKinematicsForElemsTask(domain, delt, &domain.vdov(off), &domain.v(off), &domain.vnew(off),
+                                   v_cut, eosvmin, eosvmax, numElemThis, off);
+        CalcMonotonicQGradientsForElemsTask(domain, numElemThis, off);
+    });
+    PHASE_END(PhaseKinematics);
+
+    // -------------------------------------
+    // ApplyMaterialPropertiesForElems
+    // -------------------------------------
+    if (eosTaskStats)
+        eosPhaseStartTime = WallTime();
+    std::vector<EOSChunk> &chunks = domain.eosChunks();
+    Int8_t eosWork = 0;
+    for (const EOSChunk &chunk : chunks)
+        eosWork += (Int8_t) chunk.numElem * chunk.rep;
+    auto runChain = [&domain](EOSChunk &chunk) {
+        RunEOSChain(domain, chunk.rep, chunk.regElemList, chunk.numElem);
+    };
+    if (ForkJoinTasks(eosWork) > 1)
+        hpx::for_each(hpx::execution::par, chunks.begin(), chunks.end(), runChain);
+    else
+        std::for_each(chunks.begin(), chunks.end(), runChain);
+    if (eosTaskStats)
+        eosPhaseMakespan.push_back(WallTime() - eosPhaseStartTime);
+    PHASE_END(PhaseEOS);
+    domain.DeallocateGradients();
+
+    // ----------------------------------
+    // CalcTimeConstraintsForElems
+    // ----------------------------------
+    if (!separateConstraints) {
+        // already reduced by the EOS save tasks
+        domain.dtcourant() = domain.cycleDtCourant();
+        domain.dthydro() = domain.cycleDtHydro();
+        return;
+    }
+    Real_t dtcourant = domain.dtcourant() = 1.0e+20;
+    Real_t dthydro = domain.dthydro() = 1.0e+20;
+    Real_t qqc = domain.qqc();
+    Real_t dvomax = domain.dvovmax();
+    struct ConstraintResults init = {dtcourant, dthydro};
+    auto constraints = [&](Index_t r) {
+        return CalcConstraintForElemsTask(domain, domain.regElemSize(r), domain.regElemlist(r), qqc, dtcourant,
+                                          dvomax, dthydro);
+    };
+    struct ConstraintResults final = ForkJoinTasks(numElem) > 1
+            ? hpx::transform_reduce(hpx::execution::par, counting_iterator(0), counting_iterator(domain.numReg()),
+                                    init, compareConstraintResults, constraints)
+            : hpx::transform_reduce(hpx::execution::seq, counting_iterator(0), counting_iterator(domain.numReg()),
+                                    init, compareConstraintResults, constraints);
+    domain.dtcourant() = final.dtcourant;
+    domain.dthydro() = final.dthydro;
+}
+
+// Splits the region index sets at the tile boundaries; the sets are sorted,
+// so the piece of a region in a tile is a contiguous part of its list
+static void BuildTileEOSChunks(Domain &domain) {
+    Index_t planeElems = domain.sizeX() * domain.sizeY();
+    Index_t numTiles = (domain.sizeZ() + tilePlanes - 1) / tilePlanes;
+    tileEOSChunks.assign(numTiles, {});
+    for (Index_t t = 0; t < numTiles; ++t) {
+        Index_t first = t * tilePlanes * planeElems;
+        Index_t end = std::min(domain.sizeZ(), (t + 1) * tilePlanes) * planeElems;
+        for (Int_t r = 0; r < domain.numReg(); ++r) {
+            Index_t *list = domain.regElemlist(r);
+            Index_t *lo = std::lower_bound(list, list + domain.regElemSize(r), first);
+            Index_t *hi = std::lower_bound(lo, list + domain.regElemSize(r), end);
+            if (hi != lo)
+                tileEOSChunks[t].push_back({r, CalcRegionRep(domain, r), lo, (Index_t) (hi - lo), 0.0});
+        }
+    }
+}
+
+// Futures of tiles [t + lo, t + hi] that exist
+static std::vector<hpx::shared_future<void>> TileDeps(std::vector<hpx::shared_future<void>> const &futs,
+                                                      Index_t t, Index_t lo, Index_t hi) {
+    Index_t first = std::max<Index_t>(0, t + lo);
+    Index_t last = std::min<Index_t>(futs.size() - 1, t + hi);
+    return std::vector<hpx::shared_future<void>>(futs.begin() + first, futs.begin() + last + 1);
+}
+
+// Tiled variant of LagrangeLeapFrogWithTasks (--tiles). The mesh is cut into
+// slabs of tilePlanes element planes, and each slab runs force, nodal update,
+// kinematics and gradients, EOS and constraints as a chain of tasks. A phase
+// of a tile waits only for the tiles one plane away that it shares nodes or
+// face neighbours with, and the later phases run with high priority, so that
+// a tile goes through the whole cycle while its data is still in cache.
+static void LagrangeLeapFrogTiled(Domain &domain) {
+    Index_t numNode = domain.numNode();
+    Index_t numElem = domain.numElem();
+    Int_t allElem = numElem +                             /* local elem */
+                    2 * domain.sizeX() * domain.sizeY() + /* plane ghosts */
+                    2 * domain.sizeX() * domain.sizeZ() + /* row ghosts */
+                    2 * domain.sizeY() * domain.sizeZ();  /* col ghosts */
+    Index_t numElem8 = numElem * 8;
+    Index_t planeElems = domain.sizeX() * domain.sizeY();
+    Index_t planeNodes = (domain.sizeX() + 1) * (domain.sizeY() + 1);
+    Index_t numPlanes = domain.sizeZ();
+    Index_t numTiles = tileEOSChunks.size();
+    Real_t hgcoef = domain.hgcoef();
+    const Real_t delt = domain.deltatime();
+    Real_t u_cut = domain.u_cut();
+    Real_t v_cut = domain.v_cut();
+    Real_t eosvmin = domain.eosvmin();
+    Real_t eosvmax = domain.eosvmax();
+    Real_t qqc = domain.qqc();
+    Real_t dvomax = domain.dvovmax();
+    Real_t dtcourant = domain.dtcourant() = 1.0e+20;
+    Real_t dthydro = domain.dthydro() = 1.0e+20;
+
+    Real_t *fx_elem_stress = Allocate<Real_t>(numElem8);
+    Real_t *fy_elem_stress = Allocate<Real_t>(numElem8);
+    Real_t *fz_elem_stress = Allocate<Real_t>(numElem8);
+    Real_t *fx_elem_hourglass = Allocate<Real_t>(numElem8);
+    Real_t *fy_elem_hourglass = Allocate<Real_t>(numElem8);
+    Real_t *fz_elem_hourglass = Allocate<Real_t>(numElem8);
+    domain.AllocateGradients(numElem, allElem);
+
+    // element planes [t * tilePlanes, (t + 1) * tilePlanes) and the node
+    // planes with the same indices, the last tile also the last node plane
+    auto elemOff = [=](Index_t t) {
+        return std::min(numPlanes, t * tilePlanes) * planeElems;
+    };
+    auto nodeOff = [=](Index_t t) {
+        return t == numTiles ? numNode : t * tilePlanes * planeNodes;
+    };
+    auto exec = [=](Index_t t, hpx::threads::thread_priority priority) {
+        return ChunkExecutor(ElemChunkKey(elemOff(t)), priority);
+    };
+    const hpx::threads::thread_priority high = hpx::threads::thread_priority::high;
+
+    std::vector<hpx::shared_future<void>> force(numTiles);
+    std::vector<hpx::shared_future<void>> nodal(numTiles);
+    std::vector<hpx::shared_future<void>> kinematics(numTiles);
+    std::vector<hpx::future<struct ConstraintResults>> constraints;
+    for (Index_t t = 0; t < numTiles; ++t) {
+        Index_t off = elemOff(t);
+        Index_t num = elemOff(t + 1) - off;
+        force[t] = hpx::async(exec(t, hpx::threads::thread_priority::default_), [=, &domain]() {
+            InitIntegrateStressForElemsTask(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress, num, off);
+            CalcHourglassForElemsTask(domain, &fx_elem_hourglass[off * 8], &fy_elem_hourglass[off * 8],
+                                      &fz_elem_hourglass[off * 8], hgcoef, num, off);
+        });
+    }
+    // the nodes of a tile get forces from its elements and the last element
+    // plane of the tile below
+    for (Index_t t = 0; t < numTiles; ++t) {
+        Index_t off = nodeOff(t);
+        Index_t num = nodeOff(t + 1) - off;
+        nodal[t] = hpx::when_all(TileDeps(force, t, -1, 0)).then(exec(t, high), [=, &domain](auto &&) {
+            combineVolumeForcesTaskFunc(domain, fx_elem_stress, fy_elem_stress, fz_elem_stress, fx_elem_hourglass,
+                                        fy_elem_hourglass, fz_elem_hourglass, num, off);
+            CalcAccelerationForNodesTask(&domain.fx(off), &domain.fy(off), &domain.fz(off), &domain.xdd(off),
+                                         &domain.ydd(off), &domain.zdd(off), &domain.nodalMass(off), num);
+            ApplyAccelerationBoundaryConditionsForNodeRange(domain, off, num);
+            CalcVelocityAndPositionForNodesTask(&domain.x(off), &domain.y(off), &domain.z(off), &domain.xd(off),
+                                                &domain.yd(off), &domain.zd(off), &domain.xdd(off),
+                                                &domain.ydd(off), &domain.zdd(off), delt, u_cut, num);
+        });
+    }
+    // the elements of a tile read the first node plane of the tile above
+    for (Index_t t = 0; t < numTiles; ++t) {
+        Index_t off = elemOff(t);
+        Index_t num = elemOff(t + 1) - off;
+        kinematics[t] = hpx::when_all(TileDeps(nodal, t, 0, 1)).then(exec(t, high), [=, &domain](auto &&) {
+            CalcKinematicsForElemsTask(domain, delt, &domain.vdov(off), &domain.v(off), &domain.vnew(off),
+                                       v_cut, eosvmin, eosvmax, num, off);
+            CalcMonotonicQGradientsForElemsTask(domain, num, off);
+        });
+    }
+    // the monotonic Q limiter reads the gradients of the face neighbours
+    for (Index_t t = 0; t < numTiles; ++t) {
+        constraints.push_back(hpx::when_all(TileDeps(kinematics, t, -1, 1)).then(exec(t, high), [=, &domain](auto &&) {
+            struct ConstraintResults result = {dtcourant, dthydro};
+            for (EOSChunk &chunk : tileEOSChunks[t])
+                RunEOSChain(domain, chunk.rep, chunk.regElemList, chunk.numElem);
+            if (!separateConstraints)
+                return result;
+            for (EOSChunk &chunk : tileEOSChunks[t])
+                result = compareConstraintResults(result, CalcConstraintForElemsTask(
+                        domain, chunk.numElem, chunk.regElemList, qqc, dtcourant, dvomax, dthydro));
+            return result;
+        }));
+    }
+
+    // the minima of the EOS save tasks, 1e20 with --separate-constraints;
+    // read once all tiles are done lowering them
+    std::vector<hpx::future<struct ConstraintResults>> results = hpx::when_all(constraints).get();
+    struct ConstraintResults final = {domain.cycleDtCourant(), domain.cycleDtHydro()};
+    for (hpx::future<struct ConstraintResults> &f : results)
+        final = compareConstraintResults(final, f.get());
+    domain.dtcourant() = final.dtcourant;
+    domain.dthydro() = final.dthydro;
+
+    domain.DeallocateGradients();
+    Release(&fz_elem_hourglass);
+    Release(&fy_elem_hourglass);
+    Release(&fx_elem_hourglass);
+    Release(&fz_elem_stress);
+    Release(&fy_elem_stress);
+    Release(&fx_elem_stress);
+}
+
+// Small meshes run the fork-join cycle in auto mode (opt-in); explicit task tuning
+// options keep the task graph
+static bool UseForkJoin(Domain &domain) {
+    return smallPathMode == SmallPathMode::ForkJoin ||
+           (smallPathMode == SmallPathMode::Auto && domain.numElem() <= smallPathElems &&
+            lazySplitGrain == 0 && eosRebalanceInterval == 0 && memoryPool == nullptr &&
+            !coTenancy && !nodalOverlap && !fusedPipeline && tilePlanes == 0 && !treeSpawn &&
+            !spawnStats && maxEOSChains == 0 && laggedDtSafety == 0.0 && !eosPriority);
+}
+
+// HPX threads executed so far by all pools, 0 if HPX does not count them (the
+// tasks-per-cycle counter is not installed then)
+static std::int64_t ExecutedTasks() {
+    std::int64_t executed = 0;
+#ifdef HPX_HAVE_THREAD_CUMULATIVE_COUNTS
+    for (std::size_t i = 0; i < hpx::resource::get_num_thread_pools(); ++i)
+        executed += hpx::resource::get_thread_pool(i).get_executed_threads(std::size_t(-1), false);
+#endif
+    return executed;
+}
+
+// Installs the /lulesh counter types; runs in the startup phase of the runtime
+static void RegisterCounters() {
+    using hpx::performance_counters::install_counter_type;
+    install_counter_type(
+            "/lulesh/cycle", [](bool) -> std::int64_t { return counterCycle.load(std::memory_order_relaxed); },
+            "returns the number of the last completed cycle");
+    install_counter_type(
+            "/lulesh/fom",
+            [](bool reset) -> std::int64_t {
+                double now = WallTime();
+                double start = counterFomStart.load(std::memory_order_relaxed);
+                std::int64_t zoneCycles = counterZoneCycles.load(std::memory_order_relaxed);
+                if (reset) {
+                    counterFomStart.store(now, std::memory_order_relaxed);
+                    counterZoneCycles.store(0, std::memory_order_relaxed);
+                }
+                if (start == 0.0 || now <= start)
+                    return 0;
+                // zones per millisecond, as the FOM of the final output
+                return static_cast<std::int64_t>(zoneCycles / ((now - start) * 1000.0));
+            },
+            "returns the figure of merit (zones x cycles per ms, summed over the domains) since the first cycle "
+            "or the last reset");
+#ifdef PHASE_TIMERS
+    const std::pair<const char *, CyclePhase> phases[] = {
+        {"forces", PhaseForces}, {"nodal", PhaseNodal}, {"kinematics", PhaseKinematics},
+        {"eos", PhaseEOS}, {"constraints", PhaseConstraints},
+    };
+    for (auto const &phase : phases) {
+        CyclePhase p = phase.second;
+        install_counter_type(
+                std::string("/lulesh/phase-time/") + phase.first,
+                [p](bool) -> std::int64_t { return counterPhaseTime[p].load(std::memory_order_relaxed); },
+                std::string("returns the wall time of the ") + phase.first + " phase of the last completed cycle",
+                "ns");
+    }
+#endif
+#ifdef HPX_HAVE_THREAD_CUMULATIVE_COUNTS
+    install_counter_type(
+            "/lulesh/tasks-per-cycle",
+            [](bool) -> std::int64_t { return counterTasksPerCycle.load(std::memory_order_relaxed); },
+            "returns the number of HPX threads executed during the last completed cycle");
+#endif
+    install_counter_type(
+            "/lulesh/eos-rep-work",
+            [](bool) -> std::int64_t { return counterEOSRepWork.load(std::memory_order_relaxed); },
+            "returns the EOS evaluations (elements x repetitions of their region) of the last completed cycle");
+}
+
+// Advances the domain by one time step
+static void RunCycle(Domain &domain, bool forkJoin) {
+    std::int64_t executedStart = ExecutedTasks();
+    if (counterFomStart.load(std::memory_order_relaxed) == 0.0)
+        counterFomStart.store(WallTime(), std::memory_order_relaxed);
+    if (laggedDtSafety > 0.0) {
+        laggedPrevTime = domain.time();
+        laggedPrevDt = domain.deltatime();
+    }
+#ifdef ALLOC_STATS
+    if (allocStats) {
+        allocCycleStart = AllocTotals();
+        if (allocCycles.empty())
+            allocSetup = allocCycleStart;
+    }
+#endif
+#ifdef PHASE_TIMERS
+    phaseEnd[0] = WallTime();
+#endif
+    TimeIncrement(domain);
+    PHASE_END(PhaseTimeIncrement);
+    domain.cycleDtCourant() = Real_t(1.0e+20);
+    domain.cycleDtHydro() = Real_t(1.0e+20);
+    if (tilePlanes > 0)
+        LagrangeLeapFrogTiled(domain);
+    else if (forkJoin)
+        LagrangeLeapFrogForkJoin(domain);
+    else
+        LagrangeLeapFrogWithTasks(domain);
+    PHASE_END(PhaseConstraints);
+#ifdef ALLOC_STATS
+    if (allocStats)
+        RecordAllocCycle();
+#endif
+    counterCycle.store(domain.cycle(), std::memory_order_relaxed);
+    counterZoneCycles.fetch_add(domain.numElem(), std::memory_order_relaxed);
+    counterTasksPerCycle.store(ExecutedTasks() - executedStart, std::memory_order_relaxed);
+    counterEOSRepWork.store(domain.eosRepWork(), std::memory_order_relaxed);
+#ifdef PHASE_TIMERS
+    for (Int_t phase = 0; phase < NumCyclePhases; ++phase)
+        counterPhaseTime[phase].store((std::int64_t) ((phaseEnd[phase + 1] - phaseEnd[phase]) * 1.0e9),
+                                      std::memory_order_relaxed);
+#endif
+#ifdef PHASE_TIMERS
+    if (!phaseTimesFile.empty()) {
+        CyclePhaseTimes times;
+        times.cycle = domain.cycle();
+        for (Int_t phase = 0; phase < NumCyclePhases; ++phase)
+            times.time[phase] = phaseEnd[phase + 1] - phaseEnd[phase];
+        phaseTimes.push_back(times);
+    }
+#endif
+}
+
+// Takes the handles of the thread pools created by the resource partitioner
+static void SetupThreadPools(hpx::program_options::variables_map &vm, bool quiet) {
+    if (vm.count("memory-pool-threads")) {
+        memoryPool = &hpx::resource::get_thread_pool("memory");
+        if (!quiet)
+            std::cout << "Memory pool threads: " << memoryPool->get_os_thread_count() << "\n";
+    }
+    if (vm.count("l3-pools")) {
+        for (std::size_t i = 0; i < hpx::resource::get_num_thread_pools(); ++i)
+            l3Pools.push_back(&hpx::resource::get_thread_pool(i));
+        if (!quiet)
+            std::cout << "L3 domain pools: " << l3Pools.size() << "\n";
+    }
+}
+
+// Reads the instances of an ensemble, one "s r b c [i]" per line; the
+// iterations default to --i, text after # is ignored
+static bool ReadEnsembleConfigs(std::string const &file, Int_t its, std::vector<EnsembleConfig> &configs,
+                                std::ostream &out) {
+    std::ifstream in(file);
+    if (!in) {
+        out << "ERROR: Cannot open ensemble file '" << file << "'" << std::endl;
+        return false;
+    }
+    std::string line;
+    for (Int_t lineNum = 1; std::getline(in, line); ++lineNum) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        EnsembleConfig config;
+        if (!(fields >> config.nx))
+            continue;
+        if (!(fields >> config.numReg >> config.balance >> config.cost) || config.nx < 1 || config.numReg < 1) {
+            out << "ERROR: Invalid ensemble configuration in line " << lineNum << " of '" << file
+                      << "' (expected 's r b c [i]')" << std::endl;
+            return false;
+        }
+        if (!(fields >> config.its))
+            config.its = its;
+        configs.push_back(config);
+    }
+    return true;
+}
+
+// Runs the cycles of a domain and returns their wall time
+static double RunInstance(Domain &domain, Int_t its) {
+    BuildEOSChunks(domain);
+    bool forkJoin = UseForkJoin(domain);
+
+    double start = WallTime();
+    while ((domain.time() < domain.stoptime()) && (domain.cycle() < its))
+        RunCycle(domain, forkJoin);
+    return WallTime() - start;
+}
+
+// Prints the result line of a run as in quiet mode
+static void PrintResultLine(std::ostream &out, Domain &domain, Int_t nx, Int_t numReg, double elapsed) {
+    out << nx << "," << numReg << "," << domain.cycle() << "," << hpx::get_num_worker_threads()
+        << "," << elapsed << ","
+        << std::scientific << std::setprecision(6) << std::setw(12) << domain.e(0) << std::endl;
+    out.unsetf(std::ios_base::floatfield);
+}
+
+// Runs one instance of an ensemble and prints its result line
+static void RunEnsembleInstance(EnsembleConfig const &config) {
+    Int_t col, row, plane, side;
+    InitMeshDecomp(1, 0, &col, &row, &plane, &side);
+
+    std::shared_ptr<MeshConnectivity> mesh;
+    {
+        std::lock_guard<hpx::mutex> lock(ensembleMutex);
+        mesh = ensembleMeshes[config.nx].lock();
+    }
+    std::unique_ptr<Domain> domain = std::make_unique<Domain>(1, col, row, plane, config.nx, side, config.numReg,
+                                                              config.balance, config.cost, mesh);
+    if (!mesh) {
+        std::lock_guard<hpx::mutex> lock(ensembleMutex);
+        if (ensembleMeshes[config.nx].expired())
+            ensembleMeshes[config.nx] = domain->meshConnectivity();
+    }
+    double elapsed = RunInstance(*domain, config.its);
+
+    std::lock_guard<hpx::mutex> lock(ensembleMutex);
+    PrintResultLine(std::cout, *domain, config.nx, config.numReg, elapsed);
+}
+
+// Runs the instances of an ensemble concurrently, at most maxInstances at a
+// time, so that their task graphs interleave on the workers
+static void RunEnsemble(std::vector<EnsembleConfig> const &configs, Int_t maxInstances) {
+    Index_t maxElems = 1;
+    for (EnsembleConfig const &config : configs)
+        maxElems = std::max<Index_t>(maxElems, config.nx * config.nx * config.nx);
+    numChunkKeys = NumChunkKeys(maxElems);
+
+    hpx::counting_semaphore<> slots(maxInstances);
+    std::vector<hpx::future<void>> instances;
+    instances.reserve(configs.size());
+    for (EnsembleConfig const &config : configs) {
+        instances.push_back(hpx::async([&slots, config]() {
+            slots.acquire();
+            RunEnsembleInstance(config);
+            slots.release();
+        }));
+    }
+    hpx::wait_all(instances);
+}
+
+// Table of the hardware counters per kernel, summed over the worker threads
+// (--kernel-counters). Low IPC with many LLC misses per instruction marks a
+// memory-bound kernel.
+static void PrintKernelCounters(std::ostream &out) {
+    bool supported[NumKernelCounters] = {};
+    std::uint64_t counts[NumKernels][NumKernelCounters] = {};
+    std::uint64_t calls[NumKernels] = {};
+    for (std::unique_ptr<KernelCounterThread> const &thread : kernelCounterThreads) {
+        for (Int_t c = 0; c < NumKernelCounters; ++c)
+            supported[c] = supported[c] || thread->fd[c] != -1;
+        for (Int_t k = 0; k < NumKernels; ++k) {
+            calls[k] += thread->calls[k];
+            for (Int_t c = 0; c < NumKernelCounters; ++c)
+                counts[k][c] += thread->counts[k][c];
+        }
+    }
+    if (!supported[CounterCycles]) {
+        out << "Kernel counters: perf_event_open failed (check /proc/sys/kernel/perf_event_paranoid)\n";
+        return;
+    }
+
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "Kernel counters (user space, summed over " << kernelCounterThreads.size() << " workers):\n"
+        << std::left << std::setw(46) << "kernel" << std::right << std::setw(10) << "calls" << std::setw(12)
+        << "Gcycles" << std::setw(8) << "IPC" << std::setw(14) << "LLC miss/ki" << std::setw(14) << "dTLB miss/ki"
+        << std::setw(12) << "stalled %" << "\n";
+    for (Int_t k = 0; k < NumKernels; ++k) {
+        if (calls[k] == 0)
+            continue;
+        double cycles = counts[k][CounterCycles];
+        double instructions = counts[k][CounterInstructions];
+        auto perKiloInstr = [&](Int_t c) {
+            std::ostringstream field;
+            if (supported[c] && instructions > 0)
+                field << std::fixed << std::setprecision(3) << 1000.0 * counts[k][c] / instructions;
+            else
+                field << "n/a";
+            return field.str();
+        };
+        std::ostringstream stalled;
+        if (supported[CounterStalledCycles] && cycles > 0)
+            stalled << std::fixed << std::setprecision(1) << 100.0 * counts[k][CounterStalledCycles] / cycles;
+        else
+            stalled << "n/a";
+        out << std::left << std::setw(46) << kernelNames[k] << std::right << std::setw(10) << calls[k]
+            << std::setw(12) << cycles * 1.0e-9 << std::setw(8) << (cycles > 0 ? instructions / cycles : 0.0)
+            << std::setw(14) << perKiloInstr(CounterLLCMisses) << std::setw(14) << perKiloInstr(CounterDTLBMisses)
+            << std::setw(12) << stalled.str() << "\n";
+    }
+    out.flags(flags);
+}
+
+// Machine peaks for the roofline report (--roofline), measured once before the
+// first cycle on the workers of all pools: the memory bandwidth of a STREAM triad
+// over all of them (24 bytes per element, write allocation not counted) and
+// the floating-point rate of one worker while all run independent multiply-add
+// chains, each the best of a few repetitions. The flop rate is what this build
+// reaches, so it depends on the vector width of the target. The schedule hint
+// of a probe task is not binding; repetitions in which a task ran on another
+// worker are repeated, and the peaks are marked as unpinned if none succeeds.
+struct MachinePeaks {
+    double bandwidth; // bytes/s, all workers
+    double flops;     // flop/s, one worker
+    bool pinned;      // every probe task ran on its own worker
+};
+MachinePeaks machinePeaks;
+Real_t rooflineSink; // keeps the multiply-add chains alive
+
+// Pools whose workers are probed, all of them; no two pools share a PU
+static std::vector<hpx::threads::thread_pool_base *> ProbedPools() {
+    std::vector<hpx::threads::thread_pool_base *> pools;
+    for (std::size_t i = 0; i < hpx::resource::get_num_thread_pools(); ++i)
+        pools.push_back(&hpx::resource::get_thread_pool(i));
+    return pools;
+}
+
+// Wall time of running f(w) once on each worker w of the probed pools, counted
+// over the pools; pinned is cleared if a task ran on another worker than the
+// one it was placed on
+template <typename F>
+static double TimeOnWorkers(std::vector<hpx::threads::thread_pool_base *> const &pools, F f, bool &pinned) {
+    std::vector<hpx::future<bool>> futs;
+    double t0 = WallTime();
+    std::size_t w = 0;
+    for (hpx::threads::thread_pool_base *pool : pools) {
+        for (std::size_t i = 0; i < pool->get_os_thread_count(); ++i, ++w) {
+            hpx::execution::parallel_executor exec(pool, hpx::threads::thread_priority::default_,
+                                                   hpx::threads::thread_stacksize::default_,
+                                                   hpx::threads::thread_schedule_hint(static_cast<std::int16_t>(i)));
+            futs.push_back(hpx::async(exec, [&f, w, i]() {
+                f(w);
+                return hpx::get_local_worker_thread_num() == i;
+            }));
+        }
+    }
+    hpx::wait_all(futs);
+    double t = WallTime() - t0;
+    pinned = true;
+    for (hpx::future<bool> &fut : futs)
+        pinned = fut.get() && pinned;
+    return t;
+}
+
+// Best time of repetitions runs of f on all workers, trying up to four times
+// as often for runs with every task on its own worker
+template <typename F>
+static double BestTimeOnWorkers(std::vector<hpx::threads::thread_pool_base *> const &pools, F f, Int_t repetitions,
+                                bool &pinned) {
+    double best = std::numeric_limits<double>::max();
+    double bestUnpinned = std::numeric_limits<double>::max();
+    Int_t numPinned = 0;
+    for (Int_t r = 0; r < 4 * repetitions && numPinned < repetitions; ++r) {
+        bool runPinned;
+        double t = TimeOnWorkers(pools, f, runPinned);
+        if (runPinned) {
+            best = std::min(best, t);
+            ++numPinned;
+        } else {
+            bestUnpinned = std::min(bestUnpinned, t);
+        }
+    }
+    pinned = numPinned > 0;
+    return pinned ? best : bestUnpinned;
+}
+
+static MachinePeaks MeasureMachinePeaks() {
+    const std::vector<hpx::threads::thread_pool_base *> pools = ProbedPools();
+    std::size_t numWorkers = 0;
+    for (hpx::threads::thread_pool_base *pool : pools)
+        numWorkers += pool->get_os_thread_count();
+    const Int_t repetitions = 5;
+    MachinePeaks peaks;
+
+    // 64 MB per array, beyond the last level cache; each worker first touches
+    // its own slice
+    const std::size_t n = std::size_t(1) << 23;
+    std::unique_ptr<Real_t[]> a(new Real_t[n]), b(new Real_t[n]), c(new Real_t[n]);
+    auto triad = [&](bool init) {
+        return [&, init](std::size_t w) {
+            std::size_t end = n * (w + 1) / numWorkers;
+            for (std::size_t i = n * w / numWorkers; i < end; ++i) {
+                if (init) {
+                    b[i] = Real_t(1.0);
+                    c[i] = Real_t(2.0);
+                }
+                a[i] = b[i] + Real_t(3.0) * c[i];
+            }
+        };
+    };
+    bool bandwidthPinned;
+    TimeOnWorkers(pools, triad(true), bandwidthPinned);
+    peaks.bandwidth = 3.0 * sizeof(Real_t) * n / BestTimeOnWorkers(pools, triad(false), repetitions, bandwidthPinned);
+
+    const Int_t chains = 32;
+    const Int_t iterations = 1 << 21;
+    std::vector<Real_t> sums(numWorkers);
+    auto fma = [&](std::size_t w) {
+        Real_t acc[chains];
+        for (Int_t j = 0; j < chains; ++j)
+            acc[j] = Real_t(1.0e-3) * j;
+        for (Int_t it = 0; it < iterations; ++it)
+            for (Int_t j = 0; j < chains; ++j)
+                acc[j] = acc[j] * Real_t(0.999999) + Real_t(1.0e-6);
+        sums[w] = std::accumulate(acc, acc + chains, Real_t(0.0));
+    };
+    bool flopsPinned;
+    peaks.flops = 2.0 * chains * iterations / BestTimeOnWorkers(pools, fma, repetitions, flopsPinned);
+    peaks.pinned = bandwidthPinned && flopsPinned;
+    rooflineSink = std::accumulate(sums.begin(), sums.end(), Real_t(0.0));
+    return peaks;
+}
+
+// Achieved bandwidth and flop rate per kernel against the roofline
+// (--roofline): the analytic bytes and flops of the processed elements or
+// nodes over the kernel's wall time summed over the workers, scaled to all
+// workers as if the kernel ran on each of them. The roof at the arithmetic
+// intensity I of a kernel is min(workers * peak flops, I * bandwidth).
+static void PrintRoofline(std::ostream &out) {
+    double time[NumKernels] = {};
+    std::uint64_t items[NumKernels] = {};
+    std::uint64_t calls[NumKernels] = {};
+    for (std::unique_ptr<KernelCounterThread> const &thread : kernelCounterThreads) {
+        for (Int_t k = 0; k < NumKernels; ++k) {
+            time[k] += thread->time[k];
+            items[k] += thread->items[k];
+            calls[k] += thread->calls[k];
+        }
+    }
+    double workers = kernelCounterThreads.size();
+    double peakFlops = workers * machinePeaks.flops;
+
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    out << "Roofline (" << kernelCounterThreads.size() << " workers; peaks: " << machinePeaks.bandwidth * 1.0e-9
+        << " GB/s memory bandwidth, " << machinePeaks.flops * 1.0e-9 << " GFLOP/s per worker"
+        << (machinePeaks.pinned ? "" : ", measured with probe tasks off their workers") << "):\n"
+        << std::left << std::setw(46) << "kernel" << std::right << std::setw(10) << "calls" << std::setw(12)
+        << "worker s" << std::setw(10) << "GB/s" << std::setw(10) << "GFLOP/s" << std::setw(11) << "flop/byte"
+        << std::setw(9) << "bound" << std::setw(11) << "% of roof" << "\n";
+    for (Int_t k = 0; k < NumKernels; ++k) {
+        if (calls[k] == 0 || time[k] <= 0.0)
+            continue;
+        double rate = workers / time[k];
+        double bandwidth = items[k] * kernelCosts[k].bytes * rate;
+        double flops = items[k] * kernelCosts[k].flops * rate;
+        double intensity = kernelCosts[k].flops / kernelCosts[k].bytes;
+        bool memoryBound = intensity * machinePeaks.bandwidth < peakFlops;
+        double ofRoof = memoryBound ? bandwidth / machinePeaks.bandwidth : flops / peakFlops;
+        out << std::left << std::setw(46) << kernelNames[k] << std::right << std::setw(10) << calls[k]
+            << std::setw(12) << time[k] << std::setw(10) << bandwidth * 1.0e-9 << std::setw(10) << flops * 1.0e-9
+            << std::setw(11) << intensity << std::setw(9) << (memoryBound ? "memory" : "compute") << std::setw(11)
+            << std::setprecision(1) << 100.0 * ofRoof << std::setprecision(3) << "\n";
+    }
+    out.flags(flags);
+}
+
+#ifdef ALLOC_STATS
+// Allocations per cycle (--alloc-stats): the setup before the first cycle, per
+// site the mean number and size of the Allocate and vector allocations over
+// the cycles after the first, which also pays
+// for the first use of each worker, then the totals of the first cycle and
+// their min, mean and max over the later ones
+static void PrintAllocStats(std::ostream &out) {
+    if (allocCycles.empty())
+        return;
+    std::uint64_t setupCount[NumAllocKinds] = {}, setupBytes[NumAllocKinds] = {};
+    for (Int_t site = 0; site < NumAllocSites; ++site) {
+        for (Int_t kind = 0; kind < NumAllocKinds; ++kind) {
+            setupCount[kind] += allocSetup.count[site][kind];
+            setupBytes[kind] += allocSetup.bytes[site][kind];
+        }
+    }
+    out << "Allocations: setup " << setupCount[AllocAllocate] << " Allocate (" << setupBytes[AllocAllocate] / 1024
+        << " KB), " << setupCount[AllocVector] << " vector (" << setupBytes[AllocVector] / 1024 << " KB)\n";
+    std::size_t first = allocCycles.size() > 1 ? 1 : 0;
+    std::size_t numLater = allocCycles.size() - first;
+    double later = numLater;
+    AllocCycle sums;
+    std::int64_t unreleased[NumAllocKinds] = {};
+    std::uint64_t minCount = std::numeric_limits<std::uint64_t>::max(), maxCount = 0;
+    double meanCount = 0.0, meanBytes = 0.0;
+    Int_t freeCycles = 0;
+    for (std::size_t c = 0; c < allocCycles.size(); ++c) {
+        AllocCycle const &cycle = allocCycles[c];
+        std::uint64_t count = 0, bytes = 0;
+        for (Int_t site = 0; site < NumAllocSites; ++site) {
+            for (Int_t kind = 0; kind < NumAllocKinds; ++kind) {
+                count += cycle.count[site][kind];
+                bytes += cycle.bytes[site][kind];
+                unreleased[kind] += cycle.count[site][kind];
+                if (c >= first) {
+                    sums.count[site][kind] += cycle.count[site][kind];
+                    sums.bytes[site][kind] += cycle.bytes[site][kind];
+                }
+            }
+        }
+        for (Int_t kind = 0; kind < NumAllocKinds; ++kind)
+            unreleased[kind] -= cycle.released[kind];
+        if (c == 0)
+            out << "Allocations: first cycle " << count << " (" << bytes / 1024 << " KB)\n";
+        if (c < first)
+            continue;
+        minCount = std::min(minCount, count);
+        maxCount = std::max(maxCount, count);
+        meanCount += count / later;
+        meanBytes += bytes / later;
+        freeCycles += count == 0;
+    }
+
+    std::ios_base::fmtflags flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    out << "Allocations per cycle, mean over " << numLater << " cycles" << (first ? " after the first" : "") << ":\n"
+        << std::left << std::setw(46) << "site" << std::right << std::setw(12) << "Allocate" << std::setw(12)
+        << "KB" << std::setw(12) << "vector" << std::setw(12) << "KB" << "\n";
+    for (Int_t site = 0; site < NumAllocSites; ++site) {
+        if (sums.count[site][AllocAllocate] == 0 && sums.count[site][AllocVector] == 0)
+            continue;
+        out << std::left << std::setw(46) << (site < NumKernels ? kernelNames[site] : "cycle driver (outside kernels)")
+            << std::right << std::setw(12) << sums.count[site][AllocAllocate] / later << std::setw(12)
+            << sums.bytes[site][AllocAllocate] / later / 1024 << std::setw(12) << sums.count[site][AllocVector] / later
+            << std::setw(12) << sums.bytes[site][AllocVector] / later / 1024 << "\n";
+    }
+    out << "Total per cycle: min " << minCount << ", mean " << meanCount << ", max " << maxCount << " allocations, mean "
+        << meanBytes / 1024 << " KB; " << freeCycles << " of " << numLater << " cycles without allocations\n"
+        << "Allocated minus released over all cycles: " << unreleased[AllocAllocate] << " Allocate, "
+        << unreleased[AllocVector] << " vector\n";
+    out.flags(flags);
+}
+#endif
+
+// Job files of a spool directory in name order, without the .job suffix
+static std::vector<std::string> ListSpoolJobs(std::string const &dir) {
+    std::vector<std::string> jobs;
+    DIR *spool = opendir(dir.c_str());
+    if (spool == NULL)
+        return jobs;
+    while (struct dirent *entry = readdir(spool)) {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".job") == 0)
+            jobs.push_back(name.substr(0, name.size() - 4));
+    }
+    closedir(spool);
+    std::sort(jobs.begin(), jobs.end());
+    return jobs;
+}
+
+// Runs the job files of a spool directory until a file named stop appears.
+// A job is claimed by renaming it to <name>.running, its runs go one after
+// the other and the result lines are written to <name>.out, which appears
+// when the job is done. A job whose results cannot be stored is renamed to
+// <name>.failed. The domains of the last few mesh sizes are kept and reset
+// for the next run of the same size.
+static void ServeJobs(std::string const &dir, Int_t its, bool quiet) {
+    Int_t col, row, plane, side;
+    InitMeshDecomp(1, 0, &col, &row, &plane, &side);
+
+    // most recently used last
+    std::vector<std::unique_ptr<Domain>> domains;
+    // jobs that could not be claimed, which are not tried again
+    std::set<std::string> unclaimable;
+    while (access((dir + "/stop").c_str(), F_OK) != 0) {
+        bool claimed = false;
+        for (std::string const &name : ListSpoolJobs(dir)) {
+            if (unclaimable.count(name))
+                continue;
+            std::string job = dir + "/" + name;
+            std::string running = job + ".running";
+            if (rename((job + ".job").c_str(), running.c_str()) != 0) {
+                // another server may have taken the job
+                if (errno != ENOENT) {
+                    std::cout << "ERROR: Cannot claim job '" << job << ".job': " << strerror(errno) << std::endl;
+                    unclaimable.insert(name);
+                }
+                continue;
+            }
+            claimed = true;
+
+            std::ofstream out(job + ".out.tmp");
+            std::vector<EnsembleConfig> configs;
+            Int_t reused = 0;
+            if (ReadEnsembleConfigs(job + ".running", its, configs, out)) {
+                for (EnsembleConfig const &config : configs) {
+                    auto cached = std::find_if(domains.begin(), domains.end(),
+                                               [&config](std::unique_ptr<Domain> const &d) {
+                                                   return d->sizeX() == config.nx;
+                                               });
+                    std::unique_ptr<Domain> domain;
+                    if (cached != domains.end()) {
+                        domain = std::move(*cached);
+                        domains.erase(cached);
+                        domain->Reset(config.numReg, config.balance, config.cost);
+                        ++reused;
+                    } else {
+                        domain = std::make_unique<Domain>(1, col, row, plane, config.nx, side, config.numReg,
+                                                          config.balance, config.cost);
+                    }
+                    // the runs of a job server are not concurrent, so the chunk
+                    // keys can follow the size of each run
+                    numChunkKeys = NumChunkKeys(domain->numElem());
+                    double elapsed = RunInstance(*domain, config.its);
+                    PrintResultLine(out, *domain, config.nx, config.numReg, elapsed);
+
+                    domains.push_back(std::move(domain));
+                    if (domains.size() > serveCachedDomains)
+                        domains.erase(domains.begin());
+                }
+            }
+            out.close();
+            bool stored = false;
+            if (out.fail())
+                std::cout << "ERROR: Cannot write results to '" << job << ".out.tmp'" << std::endl;
+            else if (rename((job + ".out.tmp").c_str(), (job + ".out").c_str()) != 0)
+                std::cout << "ERROR: Cannot rename '" << job << ".out.tmp': " << strerror(errno) << std::endl;
+            else
+                stored = true;
+
+            if (stored) {
+                if (unlink(running.c_str()) != 0)
+                    std::cout << "ERROR: Cannot remove '" << running << "': " << strerror(errno) << std::endl;
+            } else if (rename(running.c_str(), (job + ".failed").c_str()) != 0) {
+                std::cout << "ERROR: Cannot rename '" << running << "' to '" << job << ".failed': " << strerror(errno)
+                          << std::endl;
+            }
+            if (!quiet)
+                std::cout << "Job " << name << ": " << configs.size() << " runs, " << reused << " domains reused"
+                          << (stored ? "" : ", failed") << std::endl;
+        }
+        if (!claimed)
+            hpx::this_thread::sleep_for(std::chrono::milliseconds(servePollInterval));
+    }
+    if (unlink((dir + "/stop").c_str()) != 0)
+        std::cout << "ERROR: Cannot remove '" << dir << "/stop': " << strerror(errno) << std::endl;
 }
 
 /******************************************/
@@ -2264,6 +4611,134 @@ int hpx_main(hpx::program_options::variables_map &vm) {
     ParseCommandLineOptions(vm, myRank, &opts);
 
 
+    if (vm.count("eos-split")) {
+        std::string mode = vm["eos-split"].as<std::string>();
+        if (mode == "size") {
+            eosSplitMode = EOSSplitMode::Size;
+        } else if (mode == "cost") {
+            eosSplitMode = EOSSplitMode::Cost;
+        } else {
+            std::cout << "ERROR: Invalid argument for eos-split: '" << mode << "' (expected 'size' or 'cost')" << std::endl;
+            return hpx::local::finalize();
+        }
+    }
+    eosPriority = vm.count("eos-priority") != 0;
+    eosCoalesce = vm.count("eos-coalesce") != 0;
+    chunkAffinity = vm.count("affinity") != 0;
+    poolStats = vm.count("pool-stats") != 0;
+    coTenancy = vm.count("co-tenancy") != 0;
+    nodalDoubleBuffer = vm.count("nodal-double-buffer") != 0;
+    nodalOverlap = nodalDoubleBuffer || vm.count("nodal-overlap") != 0;
+    fusedPipeline = vm.count("fused-pipeline") != 0;
+    if (vm.count("tiles")) {
+        tilePlanes = vm["tiles"].as<Int_t>();
+        if (tilePlanes < 1) {
+            std::cout << "ERROR: Invalid argument for tiles: " << tilePlanes << std::endl;
+            return hpx::local::finalize();
+        }
+    }
+    if (!poolSetupError.empty()) {
+        std::cout << "ERROR: " << poolSetupError << std::endl;
+        return hpx::local::finalize();
+    }
+    if (vm.count("eos-rebalance")) {
+        eosRebalanceInterval = vm["eos-rebalance"].as<Int_t>();
+        if (eosRebalanceInterval < 0) {
+            std::cout << "ERROR: Invalid argument for eos-rebalance: " << eosRebalanceInterval << std::endl;
+            return hpx::local::finalize();
+        }
+    }
+    eosTaskStats = vm.count("eos-task-stats") != 0;
+    kernelCounters = vm.count("kernel-counters") != 0;
+    roofline = vm.count("roofline") != 0;
+    if (vm.count("alloc-stats")) {
+#ifdef ALLOC_STATS
+        allocStats = true;
+#else
+        std::cout << "ERROR: --alloc-stats needs a build with -DWITH_ALLOC_STATS=ON" << std::endl;
+        return hpx::local::finalize();
+#endif
+    }
+    treeSpawn = vm.count("tree-spawn") != 0;
+    separateConstraints = vm.count("separate-constraints") != 0;
+    if (vm.count("lagged-dt")) {
+        laggedDtSafety = vm["lagged-dt"].as<Real_t>();
+        if (laggedDtSafety <= 0.0 || laggedDtSafety > 1.0) {
+            std::cout << "ERROR: Invalid argument for lagged-dt: " << laggedDtSafety << " (expected 0 < s <= 1)" << std::endl;
+            return hpx::local::finalize();
+        }
+        // the constraint phase overlaps the next cycle
+        separateConstraints = true;
+    }
+    if (vm.count("max-eos-chains")) {
+        maxEOSChains = vm["max-eos-chains"].as<Int_t>();
+        if (maxEOSChains < 0) {
+            std::cout << "ERROR: Invalid argument for max-eos-chains: " << maxEOSChains << std::endl;
+            return hpx::local::finalize();
+        }
+        if (maxEOSChains > 0)
+            eosChainSlots = std::make_unique<hpx::counting_semaphore<>>(maxEOSChains);
+    }
+    spawnStats = vm.count("spawn-stats") != 0;
+    if (vm.count("small-path")) {
+        std::string mode = vm["small-path"].as<std::string>();
+        if (mode == "auto") {
+            smallPathMode = SmallPathMode::Auto;
+        } else if (mode == "tasks") {
+            smallPathMode = SmallPathMode::Tasks;
+        } else if (mode == "forkjoin") {
+            smallPathMode = SmallPathMode::ForkJoin;
+        } else {
+            std::cout << "ERROR: Invalid argument for small-path: '" << mode << "' (expected 'auto', 'tasks' or 'forkjoin')" << std::endl;
+            return hpx::local::finalize();
+        }
+    }
+    if (laggedDtSafety > 0.0 && (smallPathMode == SmallPathMode::ForkJoin || tilePlanes > 0)) {
+        // only the task graph lags the time step; auto mode keeps it for --lagged-dt
+        std::cout << "ERROR: --lagged-dt needs the phase-ordered task graph and cannot be combined with "
+                     "--small-path forkjoin or --tiles" << std::endl;
+        return hpx::local::finalize();
+    }
+    if (coTenancy && laggedDtSafety > 0.0) {
+        // the constraints of the last cycle still run between two cycles
+        std::cout << "ERROR: --co-tenancy cannot be combined with --lagged-dt" << std::endl;
+        return hpx::local::finalize();
+    }
+    if (vm.count("small-path-elems")) {
+        smallPathElems = vm["small-path-elems"].as<Int_t>();
+    }
+    if (vm.count("lazy-split")) {
+        lazySplitGrain = vm["lazy-split"].as<Int_t>();
+        if (lazySplitGrain < 0) {
+            std::cout << "ERROR: Invalid argument for lazy-split: " << lazySplitGrain << std::endl;
+            return hpx::local::finalize();
+        }
+    }
+    if (vm.count("fork-join-task-work")) {
+        forkJoinTaskWork = vm["fork-join-task-work"].as<Int_t>();
+        if (forkJoinTaskWork < 1) {
+            std::cout << "ERROR: Invalid argument for fork-join-task-work: " << forkJoinTaskWork << std::endl;
+            return hpx::local::finalize();
+        }
+    }
+    if (smallPathMode == SmallPathMode::ForkJoin) {
+        // options of the task graph, which auto mode keeps when they are given
+        const std::pair<const char *, bool> taskGraphOptions[] = {
+            {"--co-tenancy", coTenancy}, {"--tree-spawn", treeSpawn}, {"--lazy-split", lazySplitGrain > 0},
+            {"--nodal-overlap", nodalOverlap}, {"--fused-pipeline", fusedPipeline},
+            {"--max-eos-chains", maxEOSChains > 0}, {"--eos-priority", eosPriority},
+            {"--eos-rebalance", eosRebalanceInterval > 0}, {"--spawn-stats", spawnStats},
+            {"--memory-pool-threads", vm.count("memory-pool-threads") != 0}, {"--tiles", tilePlanes > 0},
+        };
+        for (auto const &option : taskGraphOptions) {
+            if (option.second) {
+                std::cout << "ERROR: " << option.first << " needs the task graph and cannot be combined with "
+                             "--small-path forkjoin" << std::endl;
+                return hpx::local::finalize();
+            }
+        }
+    }
+
     if (vm.count("task-size")) {
         std::string arg = vm["task-size"].as<std::string>();
         try {
@@ -2339,6 +4814,56 @@ int hpx_main(hpx::program_options::variables_map &vm) {
         std::cout << "Task size for CalcConstraints: " << taskSizeCalcConstraints << std::endl;
     }
 
+    if (vm.count("phase-times")) {
+#ifdef PHASE_TIMERS
+        phaseTimesFile = vm["phase-times"].as<std::string>();
+        if (tilePlanes > 0) {
+            std::cout << "ERROR: --phase-times cannot be combined with --tiles" << std::endl;
+            return hpx::local::finalize();
+        }
+#else
+        std::cout << "ERROR: --phase-times needs a build with -DWITH_PHASE_TIMERS=ON" << std::endl;
+        return hpx::local::finalize();
+#endif
+    }
+    if ((vm.count("ensemble") || vm.count("serve")) &&
+        (tilePlanes > 0 || nodalOverlap || laggedDtSafety > 0.0 || coTenancy || eosTaskStats || spawnStats ||
+         poolStats || vm.count("phase-times") || kernelCounters || roofline || vm.count("alloc-stats") || opts.viz)) {
+        std::cout << "ERROR: --ensemble and --serve cannot be combined with --tiles, --nodal-overlap, --lagged-dt, "
+                     "--co-tenancy, --v or the statistics options" << std::endl;
+        return hpx::local::finalize();
+    }
+    if (vm.count("serve")) {
+        std::string dir = vm["serve"].as<std::string>();
+        DIR *spool = opendir(dir.c_str());
+        if (spool == NULL) {
+            std::cout << "ERROR: Cannot open spool directory '" << dir << "'" << std::endl;
+            return hpx::local::finalize();
+        }
+        closedir(spool);
+        SetupThreadPools(vm, opts.quiet);
+        if (!opts.quiet)
+            std::cout << "Serving jobs from " << dir << "\n\n";
+        ServeJobs(dir, opts.its, opts.quiet);
+        return hpx::local::finalize();
+    }
+    if (vm.count("ensemble")) {
+        std::vector<EnsembleConfig> configs;
+        if (!ReadEnsembleConfigs(vm["ensemble"].as<std::string>(), opts.its, configs, std::cout))
+            return hpx::local::finalize();
+        Int_t maxInstances = vm.count("ensemble-jobs") ? vm["ensemble-jobs"].as<Int_t>()
+                                                        : Int_t(hpx::get_num_worker_threads());
+        if (maxInstances < 1) {
+            std::cout << "ERROR: Invalid argument for ensemble-jobs: " << maxInstances << std::endl;
+            return hpx::local::finalize();
+        }
+        SetupThreadPools(vm, opts.quiet);
+        if (!opts.quiet)
+            std::cout << "Ensemble: " << configs.size() << " instances, " << maxInstances << " at a time\n\n";
+        RunEnsemble(configs, maxInstances);
+        return hpx::local::finalize();
+    }
+
     if ((myRank == 0) && (opts.quiet == 0)) {
         std::cout << "Running problem size " << opts.nx
                   << "^3 per domain until completion\n";
@@ -2361,9 +4886,39 @@ int hpx_main(hpx::program_options::variables_map &vm) {
     InitMeshDecomp(numRanks, myRank, &col, &row, &plane, &side);
 
     // Build the main data structure and initialize it
+    double setupStart = WallTime();
     locDom = new Domain(numRanks, col, row, plane, opts.nx, side, opts.numReg,
                         opts.balance, opts.cost);
 
+    // Initial EOS task decomposition, may be refined with --eos-rebalance
+    double eosChunksStart = WallTime();
+    BuildEOSChunks(*locDom);
+    if (vm.count("startup-stats")) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        out << "Startup (s):";
+        for (const std::pair<const char *, double> &step : locDom->setupTimes())
+            out << " " << step.first << " " << step.second << ",";
+        out << " EOS chunks " << WallTime() - eosChunksStart << ", total " << WallTime() - setupStart << "\n";
+    }
+
+    numChunkKeys = NumChunkKeys(locDom->numElem());
+    SetupThreadPools(vm, opts.quiet);
+
+    useForkJoin = UseForkJoin(*locDom);
+    if (nodalDoubleBuffer)
+        locDom->AllocateNodalBuffers();
+    if (tilePlanes > 0)
+        BuildTileEOSChunks(*locDom);
+    if (!opts.quiet) {
+        if (tilePlanes > 0)
+            std::cout << "Cycle mode: tiled (" << tileEOSChunks.size() << " tiles of " << tilePlanes << " planes)\n\n";
+        else
+            std::cout << "Cycle mode: " << (useForkJoin ? "fork-join" : "tasks") << "\n\n";
+    }
+
+    if (roofline)
+        machinePeaks = MeasureMachinePeaks();
+
     // BEGIN timestep to solution */
     timeval start;
     gettimeofday(&start, NULL);
@@ -2374,8 +4929,7 @@ int hpx_main(hpx::program_options::variables_map &vm) {
     while ((locDom->time() < locDom->stoptime()) &&
            (locDom->cycle() < opts.its)) {
 
-        TimeIncrement(*locDom);
-        LagrangeLeapFrogWithTasks(*locDom);
+        RunCycle(*locDom, useForkJoin);
 
         if ((opts.showProg != 0) && (opts.quiet == 0) && (myRank == 0) && (locDom->cycle() % 100 == 0)) {
             std::cout << "cycle = " << locDom->cycle() << ", " << std::scientific
@@ -2384,6 +4938,9 @@ int hpx_main(hpx::program_options::variables_map &vm) {
             std::cout.unsetf(std::ios_base::floatfield);
         }
     }
+    if (pendingConstraints.valid())
+        pendingConstraints.get();
+    EndSerialSection();
 
     // Use reduced max elapsed time
     double elapsed_time;
@@ -2394,6 +4951,78 @@ int hpx_main(hpx::program_options::variables_map &vm) {
     double elapsed_timeG;
     elapsed_timeG = elapsed_time;
 
+    if (eosTaskStats) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        out << "EOS split mode: " << (eosSplitMode == EOSSplitMode::Cost ? "cost" : "size")
+            << ", priority launch: " << (eosPriority ? "on" : "off")
+            << ", coalescing: " << (eosCoalesce ? "on" : "off")
+            << ", EOS chunks: " << locDom->eosChunks().size() << "\n";
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        out << "EOS chain limit: ";
+        if (maxEOSChains > 0)
+            out << maxEOSChains;
+        else
+            out << "none";
+        out << ", peak resident set size: " << usage.ru_maxrss / 1024 << " MB\n";
+        PrintSampleStats(out, "EOS phase makespan", eosPhaseMakespan, 1.0e6, "us");
+        PrintSampleStats(out, "EOS chain duration", eosTaskDurations, 1.0e6, "us");
+        PrintSampleStats(out, "EOS chain imbalance per cycle", eosCycleImbalance, 1.0, "max/mean");
+    }
+    if (spawnStats) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        out << "Task spawning: " << (treeSpawn ? "one spawner per region" : "single spawner") << "\n";
+        PrintSampleStats(out, "Start of the last EOS task", eosLastTaskStart, 1.0e6, "us");
+        PrintSampleStats(out, "Start of the last constraint task", constraintLastTaskStart, 1.0e6, "us");
+    }
+    if (poolStats) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        std::size_t forceThreads = hpx::resource::get_thread_pool(0).get_os_thread_count();
+        std::size_t nodalThreads = (memoryPool && !useForkJoin) ? memoryPool->get_os_thread_count() : forceThreads;
+        out << "Threads: " << forceThreads << " (force phase), " << nodalThreads
+            << " (nodal phases)\n";
+        PrintSampleStats(out, "Force phase", forcePhaseTime, 1.0e6, "us");
+        PrintSampleStats(out, "Combine forces and acceleration phase", combinePhaseTime, 1.0e6, "us");
+        PrintSampleStats(out, "Velocity and position phase", positionPhaseTime, 1.0e6, "us");
+        if (nodalOverlap)
+            PrintSampleStats(out, "Overlap of position updates and kinematics", nodalOverlapTime, 1.0e6, "us");
+    }
+    if (laggedDtSafety > 0.0) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        out << "Lagged time step: safety factor " << laggedDtSafety << ", " << laggedDtFallbacks
+            << " synchronous fallbacks in " << locDom->cycle() << " cycles\n";
+    }
+    if (coTenancy) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        PrintSampleStats(out, "Serial section between cycles", serialTime, 1.0e6, "us");
+        PrintSampleStats(out, "Worker suspension", suspendTime, 1.0e6, "us");
+        PrintSampleStats(out, "Worker resumption", resumeTime, 1.0e6, "us");
+    }
+    if (kernelCounters) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        PrintKernelCounters(out);
+        CloseKernelCounters();
+    }
+    if (roofline) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        PrintRoofline(out);
+    }
+#ifdef ALLOC_STATS
+    if (allocStats) {
+        allocStats = false;
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        PrintAllocStats(out);
+    }
+#endif
+#ifdef PHASE_TIMERS
+    if (!phaseTimesFile.empty()) {
+        std::ostream &out = opts.quiet ? std::cerr : std::cout;
+        PrintPhaseTimes(out, phaseTimes);
+        if (!WritePhaseTimes(phaseTimesFile, phaseTimes))
+            out << "ERROR: Cannot write phase times to '" << phaseTimesFile << "'\n";
+    }
+#endif
+
     // Write out final viz file */
     if (opts.viz) {
         DumpToVisit(*locDom, opts.numFiles, myRank, numRanks);
@@ -2402,9 +5031,7 @@ int hpx_main(hpx::program_options::variables_map &vm) {
     if ((myRank == 0) && (opts.quiet == 0)) {
         VerifyAndWriteFinalOutput(elapsed_timeG, *locDom, opts.nx, numRanks);
     } else {
-        std::cout << opts.nx << "," << opts.numReg << "," << locDom->cycle() << "," << hpx::get_num_worker_threads()
-                  << "," << elapsed_timeG << ","
-                  << std::scientific << std::setprecision(6) << std::setw(12) << locDom->e(0) << std::endl;
+        PrintResultLine(std::cout, *locDom, opts.nx, opts.numReg, elapsed_timeG);
     }
 
     delete locDom;
@@ -2412,6 +5039,105 @@ int hpx_main(hpx::program_options::variables_map &vm) {
     return hpx::local::finalize();
 }
 
+// Creates one thread pool per L3 cache domain found by hwloc (--l3-pools).
+// The PUs of the first domain stay in the default pool.
+static void CreateL3Pools(hpx::resource::partitioner &rp, hpx::program_options::variables_map const &vm) {
+    hwloc_topology_t topology;
+    hwloc_topology_init(&topology);
+    hwloc_topology_load(topology);
+    std::vector<int> domainOfPU(hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_PU), 0);
+    int numL3 = hwloc_get_nbobjs_by_type(topology, HWLOC_OBJ_L3CACHE);
+    for (int d = 0; d < numL3; ++d) {
+        hwloc_obj_t l3 = hwloc_get_obj_by_type(topology, HWLOC_OBJ_L3CACHE, d);
+        hwloc_obj_t pu = nullptr;
+        while ((pu = hwloc_get_next_obj_inside_cpuset_by_type(topology, l3->cpuset, HWLOC_OBJ_PU, pu)) != nullptr)
+            domainOfPU[pu->logical_index] = d;
+    }
+    hwloc_topology_destroy(topology);
+
+    // pool name per domain, the first domain seen keeps the default pool
+    std::vector<std::string> poolOfDomain(std::max(numL3, 1));
+    bool first = true;
+    for (const hpx::resource::numa_domain &numa : rp.numa_domains()) {
+        for (const hpx::resource::core &core : numa.cores()) {
+            for (const hpx::resource::pu &pu : core.pus()) {
+                int d = pu.id() < domainOfPU.size() ? domainOfPU[pu.id()] : 0;
+                if (poolOfDomain[d].empty()) {
+                    poolOfDomain[d] = first ? "default" : "l3-" + std::to_string(d);
+                    if (!first)
+                        rp.create_thread_pool(poolOfDomain[d], hpx::resource::scheduling_policy::unspecified,
+                                              poolSchedulerMode);
+                    first = false;
+                }
+                if (poolOfDomain[d] != "default")
+                    rp.add_resource(pu, poolOfDomain[d]);
+            }
+        }
+    }
+}
+
+// Creates the pool "memory" for the nodal phases (--memory-pool-threads). Its
+// threads are spread over the NUMA domains, so that every memory controller
+// is used. Its PUs are taken out of the default pool: idle workers spin, so two
+// workers sharing a PU would take cycles from each other in every phase.
+static void CreateMemoryPool(hpx::resource::partitioner &rp, Int_t numThreads) {
+    rp.create_thread_pool("memory", hpx::resource::scheduling_policy::unspecified, poolSchedulerMode);
+    std::size_t numDomains = rp.numa_domains().size();
+    for (std::size_t d = 0; d < numDomains; ++d) {
+        const hpx::resource::numa_domain &numa = rp.numa_domains()[d];
+        Int_t n = numThreads / numDomains + ((Int_t) d < numThreads % (Int_t) numDomains ? 1 : 0);
+        for (const hpx::resource::core &core : numa.cores()) {
+            for (const hpx::resource::pu &pu : core.pus()) {
+                if (n > 0 && &pu == &core.pus().front()) {
+                    rp.add_resource(pu, "memory");
+                    --n;
+                } else {
+                    rp.add_resource(pu, "default");
+                }
+            }
+        }
+    }
+}
+
+// Resource partitioner callback: sets up the scheduler mode of the pools for
+// --co-tenancy and the thread pools of --l3-pools or
+// --memory-pool-threads. Invalid pool options are checked here, before any
+// pool is created, and reported by hpx_main.
+static void CreateThreadPools(hpx::resource::partitioner &rp, hpx::program_options::variables_map const &vm) {
+    if (vm.count("memory-pool-threads") && vm.count("l3-pools")) {
+        poolSetupError = "--memory-pool-threads cannot be combined with --l3-pools";
+        return;
+    }
+    if (vm.count("memory-pool-threads") && vm["memory-pool-threads"].as<Int_t>() < 1) {
+        poolSetupError = "Invalid argument for memory-pool-threads: " +
+                         std::to_string(vm["memory-pool-threads"].as<Int_t>());
+        return;
+    }
+    if (vm.count("memory-pool-threads")) {
+        // the default pool keeps at least one core
+        std::size_t numCores = 0;
+        for (const hpx::resource::numa_domain &numa : rp.numa_domains())
+            numCores += numa.cores().size();
+        if ((std::size_t) vm["memory-pool-threads"].as<Int_t>() >= numCores) {
+            poolSetupError = "--memory-pool-threads must be less than the number of cores (" +
+                             std::to_string(numCores) + ")";
+            return;
+        }
+    }
+    if (vm.count("co-tenancy")) {
+        // suspension needs an elastic scheduler; idle backoff lets workers
+        // sleep when the queues run short within the parallel phases
+        poolSchedulerMode = hpx::threads::policies::scheduler_mode::default_ |
+                            hpx::threads::policies::scheduler_mode::enable_elasticity |
+                            hpx::threads::policies::scheduler_mode::enable_idle_backoff;
+        rp.create_thread_pool("default", hpx::resource::scheduling_policy::unspecified, poolSchedulerMode);
+    }
+    if (vm.count("l3-pools"))
+        CreateL3Pools(rp, vm);
+    else if (vm.count("memory-pool-threads"))
+        CreateMemoryPool(rp, vm["memory-pool-threads"].as<Int_t>());
+}
+
 int main(int argc, char *argv[]) {
     hpx::init_params init_args;
 
@@ -2429,10 +5155,43 @@ int main(int argc, char *argv[]) {
             ("p", "Print out progress")
             ("v", "Output viz file (requires cimpiling with -DVIZ_MESH")
             ("elems-per-task", value<Int_t>(), "Elements per HPX task")
-            ("task-size", value<std::string>(), "Task sizes for different program sections");
+            ("task-size", value<std::string>(), "Task sizes for different program sections")
+            ("eos-split", value<std::string>(), "Split regions into EOS tasks by 'size' (default) or 'cost' (elements x rep)")
+            ("eos-priority", "Submit EOS tasks of expensive regions first and with high priority")
+            ("eos-coalesce", "Pack small regions with the same cost into combined EOS tasks")
+            ("eos-rebalance", value<Int_t>(), "Re-chunk regions every n cycles based on measured EOS task times")
+            ("eos-task-stats", "Print duration statistics of the EOS task chains and phase")
+            ("max-eos-chains", value<Int_t>(), "Limit the EOS task chains holding scratch buffers at the same time to n")
+            ("separate-constraints", "Compute the time constraints in a phase after the EOS instead of in the EOS save tasks")
+            ("lagged-dt", value<Real_t>(), "Start each cycle with a dt from the constraints of the cycle before the last one, scaled by the given safety factor")
+            ("startup-stats", "Print the wall time of the setup steps of the domain")
+            ("phase-times", value<std::string>(), "Write the wall time of each phase per cycle and their statistics to a file, JSON for names ending in .json and CSV otherwise (needs a build with WITH_PHASE_TIMERS)")
+            ("kernel-counters", "Count cycles, instructions, LLC misses, dTLB misses and stalled cycles per kernel with perf_event_open and print a table at the end")
+            ("alloc-stats", "Count the Allocate calls and domain array allocations and their bytes per cycle by kernel and print a summary at the end (needs a build with -DWITH_ALLOC_STATS=ON)")
+            ("roofline", "Measure the wall time per kernel and print its achieved bandwidth and flop rate from analytic byte and flop counts against machine peaks measured at startup")
+            ("ensemble", value<std::string>(), "Run the configurations listed in a file, one 's r b c [i]' per line, as concurrent instances and print a result line for each")
+            ("ensemble-jobs", value<Int_t>(), "Maximum number of ensemble instances that run at the same time (default: number of worker threads)")
+            ("serve", value<std::string>(), "Run as a job server: run the configurations of each <name>.job file in the given spool directory, write the result lines to <name>.out and stop when a file named stop appears")
+            ("tree-spawn", "Launch the EOS and constraint tasks from one spawner task per region")
+            ("spawn-stats", "Print how long after the start of the EOS and constraint phases their last task starts")
+            ("small-path", value<std::string>(), "Cycle mode: 'tasks' (default), 'forkjoin' or 'auto' (fork-join for small problems)")
+            ("fork-join-task-work", value<Int_t>(), "Minimum work of a fork-join task in element updates, less work runs inline (default 4096)")
+            ("small-path-elems", value<Int_t>(), "Largest number of elements run in fork-join mode by '--small-path auto' (default 32768)")
+            ("l3-pools", "Run groups of spatially adjacent chunks in one HPX thread pool per L3 cache domain")
+            ("memory-pool-threads", value<Int_t>(), "Run the nodal phases in a separate pool with n threads spread over the NUMA domains")
+            ("pool-stats", "Print the durations of the force and nodal phases")
+            ("nodal-overlap", "Start the kinematics of an element chunk as soon as the node chunks of its nodes are updated")
+            ("nodal-double-buffer", "Like --nodal-overlap, with separate arrays for the previous and current nodal state")
+            ("fused-pipeline", "Start each EOS task chain once the gradients of its elements and their neighbours are done")
+            ("tiles", value<Int_t>(), "Run the whole cycle tile by tile on slabs of n element planes")
+            ("co-tenancy", "Suspend idle HPX workers between cycles for jobs sharing the node")
+            ("affinity", "Place chunk k of every phase on worker k mod P, other workers only steal it when idle")
+            ("lazy-split", value<Int_t>(), "Split element and region loops lazily when workers are idle, down to n elements per task");
 
     // Initialize HPX, run hpx_main as the first HPX thread, and
     // wait for hpx::finalize being called.
     init_args.desc_cmdline = desc_commandline;
+    init_args.rp_callback = &CreateThreadPools;
+    hpx::register_startup_function(&RegisterCounters);
     return hpx::init(argc, argv, init_args);
 }
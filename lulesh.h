@@ -4,6 +4,11 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <string>
 #include <vector>
 
 #include <hpx/modules/program_options.hpp>
@@ -89,9 +94,52 @@ inline real10 FABS(real10 arg) { return fabsl(arg) ; }
 /* might want to add access methods so that memory can be */
 /* better managed, as in luleshFT */
 
+#ifdef ALLOC_STATS
+// Allocation accounting of --alloc-stats (built with ALLOC_STATS)
+void CountAllocate(size_t bytes) ;
+void CountRelease() ;
+void CountVectorAllocate(size_t bytes) ;
+void CountVectorRelease() ;
+
+// Allocator of the arrays of the domain and its mesh, counted as vector
+// allocations; the memory itself comes from std::allocator as without
+// ALLOC_STATS
+template <typename T>
+struct CountingAllocator {
+   typedef T value_type ;
+   CountingAllocator() = default ;
+   template <typename U>
+   CountingAllocator(const CountingAllocator<U>&) {}
+   T *allocate(size_t n)
+   {
+      CountVectorAllocate(sizeof(T)*n) ;
+      return std::allocator<T>().allocate(n) ;
+   }
+   void deallocate(T *ptr, size_t n)
+   {
+      CountVectorRelease() ;
+      std::allocator<T>().deallocate(ptr, n) ;
+   }
+} ;
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>&, const CountingAllocator<U>&) { return true ; }
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>&, const CountingAllocator<U>&) { return false ; }
+
+template <typename T>
+using DomainVector = std::vector<T, CountingAllocator<T> > ;
+#else
+template <typename T>
+using DomainVector = std::vector<T> ;
+#endif
+
 template <typename T>
 T *Allocate(size_t size)
 {
+#ifdef ALLOC_STATS
+   CountAllocate(sizeof(T)*size) ;
+#endif
    return static_cast<T *>(malloc(sizeof(T)*size)) ;
 }
 
@@ -99,11 +147,42 @@ template <typename T>
 void Release(T **ptr)
 {
    if (*ptr != NULL) {
+#ifdef ALLOC_STATS
+      CountRelease() ;
+#endif
       free(*ptr) ;
       *ptr = NULL ;
    }
 }
 
+// Contiguous part of a region's element list processed by one EOS task chain
+struct EOSChunk {
+   Int_t    reg ;           // region index, -1 for coalesced small regions
+   Int_t    rep ;           // EOS evaluations per element
+   Index_t *regElemList ;   // first element of the chunk in the region index set
+   Index_t  numElem ;
+   double   measuredTime ;  // work time of the last sampled cycle (--eos-rebalance)
+} ;
+
+// Connectivity and reference volumes and masses, which only depend on the
+// mesh size and decomposition, shared by the domains of an ensemble run that
+// have the same mesh (--ensemble)
+struct MeshConnectivity {
+   DomainVector<Index_t> nodelist ;     // elemToNode connectivity
+   DomainVector<Index_t> lxim ;         // element connectivity across each face
+   DomainVector<Index_t> lxip ;
+   DomainVector<Index_t> letam ;
+   DomainVector<Index_t> letap ;
+   DomainVector<Index_t> lzetam ;
+   DomainVector<Index_t> lzetap ;
+   DomainVector<Int_t>   elemBC ;       // symmetry/free-surface flags
+   DomainVector<Index_t> nodeElemStart ;
+   DomainVector<Index_t> nodeElemCornerList ;
+   DomainVector<Real_t>  volo ;         // reference volume
+   DomainVector<Real_t>  elemMass ;
+   DomainVector<Real_t>  nodalMass ;
+} ;
+
 //////////////////////////////////////////////////////
 // Primary data structure
 //////////////////////////////////////////////////////
@@ -134,11 +213,16 @@ class Domain {
    // Constructor
    Domain(Int_t numRanks, Index_t colLoc,
           Index_t rowLoc, Index_t planeLoc,
-          Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost);
+          Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost,
+          std::shared_ptr<MeshConnectivity> mesh = nullptr);
 
    // Destructor
    ~Domain();
 
+   // Back to the initial state with new regions, keeping the mesh and the
+   // allocations (--serve)
+   void Reset(Int_t nr, Int_t balance, Int_t cost);
+
    //
    // ALLOCATION
    //
@@ -161,22 +245,40 @@ class Domain {
       m_fy.resize(numNode);
       m_fz.resize(numNode);
 
-      m_nodalMass.resize(numNode);  // mass
+      m_nodalMass = m_mesh->nodalMass.data();  // mass
    }
 
-   void AllocateElemPersistent(Int_t numElem) // Elem-centered
+   void AllocateMeshConnectivity(Int_t numElem, Int_t numNode)
    {
-      m_nodelist.resize(8*numElem);
+      m_mesh->nodelist.resize(8*numElem);
 
       // elem connectivities through face
-      m_lxim.resize(numElem);
-      m_lxip.resize(numElem);
-      m_letam.resize(numElem);
-      m_letap.resize(numElem);
-      m_lzetam.resize(numElem);
-      m_lzetap.resize(numElem);
+      m_mesh->lxim.resize(numElem);
+      m_mesh->lxip.resize(numElem);
+      m_mesh->letam.resize(numElem);
+      m_mesh->letap.resize(numElem);
+      m_mesh->lzetam.resize(numElem);
+      m_mesh->lzetap.resize(numElem);
+
+      m_mesh->elemBC.resize(numElem);
+
+      m_mesh->volo.resize(numElem);
+      m_mesh->elemMass.resize(numElem);
+      m_mesh->nodalMass.resize(numNode);
+   }
 
-      m_elemBC.resize(numElem);
+   void AllocateElemPersistent(Int_t numElem) // Elem-centered
+   {
+      m_nodelist = m_mesh->nodelist.data();
+      m_lxim = m_mesh->lxim.data();
+      m_lxip = m_mesh->lxip.data();
+      m_letam = m_mesh->letam.data();
+      m_letap = m_mesh->letap.data();
+      m_lzetam = m_mesh->lzetam.data();
+      m_lzetap = m_mesh->lzetap.data();
+      m_elemBC = m_mesh->elemBC.data();
+      m_volo = m_mesh->volo.data();
+      m_elemMass = m_mesh->elemMass.data();
 
       m_e.resize(numElem);
       m_p.resize(numElem);
@@ -187,7 +289,6 @@ class Domain {
 
       m_v.resize(numElem);
 
-      m_volo.resize(numElem);
       m_delv.resize(numElem);
       m_vdov.resize(numElem);
 
@@ -195,8 +296,6 @@ class Domain {
 
       m_ss.resize(numElem);
 
-      m_elemMass.resize(numElem);
-
       m_vnew.resize(numElem) ;
    }
 
@@ -224,6 +323,29 @@ class Domain {
       Release(&m_delv_xi)  ;
    }
 
+   // Second set of nodal coordinates and velocities (--nodal-double-buffer)
+   void AllocateNodalBuffers()
+   {
+      m_x_prev = m_x ;
+      m_y_prev = m_y ;
+      m_z_prev = m_z ;
+      m_xd_prev = m_xd ;
+      m_yd_prev = m_yd ;
+      m_zd_prev = m_zd ;
+   }
+
+   // The current nodal state becomes the previous one; the position update
+   // then writes all of x/y/z and xd/yd/zd from the previous state
+   void SwapNodalBuffers()
+   {
+      m_x.swap(m_x_prev) ;
+      m_y.swap(m_y_prev) ;
+      m_z.swap(m_z_prev) ;
+      m_xd.swap(m_xd_prev) ;
+      m_yd.swap(m_yd_prev) ;
+      m_zd.swap(m_zd_prev) ;
+   }
+
    void AllocateStrains(Int_t numElem)
    {
       m_dxx = Allocate<Real_t>(numElem) ;
@@ -284,6 +406,18 @@ class Domain {
    Index_t*  regElemlist(Int_t r)    { return m_regElemlist[r] ; }
    Index_t&  regElemlist(Int_t r, Index_t idx) { return m_regElemlist[r][idx] ; }
 
+   // EOS task chunks of all regions, ordered by region
+   std::vector<EOSChunk>& eosChunks() { return m_eosChunks ; }
+   Int8_t& eosRepWork() { return m_eosRepWork ; }
+   // element lists of EOS chunks that combine several small regions
+   std::vector<std::vector<Index_t> >& eosCoalescedLists() { return m_eosCoalescedLists ; }
+
+   // wall time of each setup step of the constructor, in order
+   std::vector<std::pair<const char*, double> >& setupTimes() { return m_setupTimes ; }
+
+   // connectivity of the mesh, shared with other domains of the same mesh
+   std::shared_ptr<MeshConnectivity> meshConnectivity() { return m_mesh ; }
+
    Index_t*  nodelist(Index_t idx)    { return &m_nodelist[Index_t(8)*idx] ; }
 
    // elem connectivities through face
@@ -366,6 +500,12 @@ class Domain {
    Real_t* yd_end() { return m_yd.data() + m_yd.size(); }
    Real_t* zd_begin() { return m_zd.data(); }
    Real_t* zd_end() { return m_zd.data() + m_zd.size(); }
+   Real_t* x_prev_begin() { return m_x_prev.data(); }
+   Real_t* y_prev_begin() { return m_y_prev.data(); }
+   Real_t* z_prev_begin() { return m_z_prev.data(); }
+   Real_t* xd_prev_begin() { return m_xd_prev.data(); }
+   Real_t* yd_prev_begin() { return m_yd_prev.data(); }
+   Real_t* zd_prev_begin() { return m_zd_prev.data(); }
    Real_t* xdd_begin() { return m_xdd.data(); }
    Real_t* ydd_begin() { return m_ydd.data(); }
    Real_t* zdd_begin() { return m_zdd.data(); }
@@ -386,10 +526,10 @@ class Domain {
    Real_t* v_end() { return m_v.data() + m_v.size(); }
    Real_t* vnew_begin() { return m_vnew.data(); }
    Real_t* vnew_end() { return m_vnew.data() + m_vnew.size(); }
-   Real_t* nodalMass_begin() { return m_nodalMass.data(); }
+   Real_t* nodalMass_begin() { return m_nodalMass; }
    Real_t *vdov_begin() { return m_vdov.data(); }
    Real_t *ss_begin() { return m_ss.data(); }
-   Real_t *elemMass_begin() { return m_elemMass.data(); }
+   Real_t *elemMass_begin() { return m_elemMass; }
 
    // Parameters
 
@@ -425,6 +565,9 @@ class Domain {
    Real_t& stoptime()             { return m_stoptime ; }
    Real_t& dtcourant()            { return m_dtcourant ; }
    Real_t& dthydro()              { return m_dthydro ; }
+   // minima of the time constraints reduced by the EOS save tasks
+   std::atomic<Real_t>& cycleDtCourant() { return m_cycleDtCourant ; }
+   std::atomic<Real_t>& cycleDtHydro()   { return m_cycleDtHydro ; }
    Real_t& dtmax()                { return m_dtmax ; }
    Real_t& dtfixed()              { return m_dtfixed ; }
 
@@ -450,6 +593,9 @@ class Domain {
   private:
 
    void BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems);
+   void BuildElemNodeLists(Int_t edgeNodes, Int_t edgeElems);
+   void InitializeFields();
+   void SetupInitialConditions(Index_t nx);
    void SetupThreadSupportStructures();
    void CreateRegionIndexSets(Int_t nreg, Int_t balance);
    void SetupCommBuffers(Int_t edgeNodes);
@@ -462,27 +608,34 @@ class Domain {
    //
 
    /* Node-centered */
-   std::vector<Real_t> m_x ;  /* coordinates */
-   std::vector<Real_t> m_y ;
-   std::vector<Real_t> m_z ;
+   DomainVector<Real_t> m_x ;  /* coordinates */
+   DomainVector<Real_t> m_y ;
+   DomainVector<Real_t> m_z ;
+
+   DomainVector<Real_t> m_xd ; /* velocities */
+   DomainVector<Real_t> m_yd ;
+   DomainVector<Real_t> m_zd ;
 
-   std::vector<Real_t> m_xd ; /* velocities */
-   std::vector<Real_t> m_yd ;
-   std::vector<Real_t> m_zd ;
+   DomainVector<Real_t> m_x_prev ;  /* previous coordinates and velocities */
+   DomainVector<Real_t> m_y_prev ;  /* (--nodal-double-buffer) */
+   DomainVector<Real_t> m_z_prev ;
+   DomainVector<Real_t> m_xd_prev ;
+   DomainVector<Real_t> m_yd_prev ;
+   DomainVector<Real_t> m_zd_prev ;
 
-   std::vector<Real_t> m_xdd ; /* accelerations */
-   std::vector<Real_t> m_ydd ;
-   std::vector<Real_t> m_zdd ;
+   DomainVector<Real_t> m_xdd ; /* accelerations */
+   DomainVector<Real_t> m_ydd ;
+   DomainVector<Real_t> m_zdd ;
 
-   std::vector<Real_t> m_fx ;  /* forces */
-   std::vector<Real_t> m_fy ;
-   std::vector<Real_t> m_fz ;
+   DomainVector<Real_t> m_fx ;  /* forces */
+   DomainVector<Real_t> m_fy ;
+   DomainVector<Real_t> m_fz ;
 
-   std::vector<Real_t> m_nodalMass ;  /* mass */
+   Real_t              *m_nodalMass ;  /* mass */
 
-   std::vector<Index_t> m_symmX ;  /* symmetry plane nodesets */
-   std::vector<Index_t> m_symmY ;
-   std::vector<Index_t> m_symmZ ;
+   DomainVector<Index_t> m_symmX ;  /* symmetry plane nodesets */
+   DomainVector<Index_t> m_symmY ;
+   DomainVector<Index_t> m_symmZ ;
 
    // Element-centered
 
@@ -492,17 +645,26 @@ class Domain {
    Index_t *m_regElemSize ;   // Size of region sets
    Index_t *m_regNumList ;    // Region number per domain element
    Index_t **m_regElemlist ;  // region indexset
+   std::vector<EOSChunk> m_eosChunks ; // EOS task decomposition of the regions
+   Int8_t   m_eosRepWork ;  // EOS evaluations per cycle (elements x rep)
+   std::vector<std::vector<Index_t> > m_eosCoalescedLists ;
+   std::vector<std::pair<const char*, double> > m_setupTimes ;
+
+   std::shared_ptr<MeshConnectivity> m_mesh ;
 
-   std::vector<Index_t>  m_nodelist ;     /* elemToNode connectivity */
+   Index_t              *m_nodelist ;     /* elemToNode connectivity */
 
-   std::vector<Index_t>  m_lxim ;  /* element connectivity across each face */
-   std::vector<Index_t>  m_lxip ;
-   std::vector<Index_t>  m_letam ;
-   std::vector<Index_t>  m_letap ;
-   std::vector<Index_t>  m_lzetam ;
-   std::vector<Index_t>  m_lzetap ;
+   Index_t              *m_lxim ;  /* element connectivity across each face */
+   Index_t              *m_lxip ;
+   Index_t              *m_letam ;
+   Index_t              *m_letap ;
+   Index_t              *m_lzetam ;
+   Index_t              *m_lzetap ;
 
-   std::vector<Int_t>    m_elemBC ;  /* symmetry/free-surface flags for each elem face */
+   Int_t                *m_elemBC ;  /* symmetry/free-surface flags for each elem face */
+
+   Real_t               *m_volo ;      /* reference volume */
+   Real_t               *m_elemMass ;  /* mass */
 
    Real_t             *m_dxx ;  /* principal strains -- temporary */
    Real_t             *m_dyy ;
@@ -516,24 +678,21 @@ class Domain {
    Real_t             *m_delx_eta ;
    Real_t             *m_delx_zeta ;
 
-   std::vector<Real_t> m_e ;   /* energy */
-
-   std::vector<Real_t> m_p ;   /* pressure */
-   std::vector<Real_t> m_q ;   /* q */
-   std::vector<Real_t> m_ql ;  /* linear term for q */
-   std::vector<Real_t> m_qq ;  /* quadratic term for q */
+   DomainVector<Real_t> m_e ;   /* energy */
 
-   std::vector<Real_t> m_v ;     /* relative volume */
-   std::vector<Real_t> m_volo ;  /* reference volume */
-   std::vector<Real_t> m_vnew ;  /* new relative volume -- temporary */
-   std::vector<Real_t> m_delv ;  /* m_vnew - m_v */
-   std::vector<Real_t> m_vdov ;  /* volume derivative over volume */
+   DomainVector<Real_t> m_p ;   /* pressure */
+   DomainVector<Real_t> m_q ;   /* q */
+   DomainVector<Real_t> m_ql ;  /* linear term for q */
+   DomainVector<Real_t> m_qq ;  /* quadratic term for q */
 
-   std::vector<Real_t> m_arealg ;  /* characteristic length of an element */
+   DomainVector<Real_t> m_v ;     /* relative volume */
+   DomainVector<Real_t> m_vnew ;  /* new relative volume -- temporary */
+   DomainVector<Real_t> m_delv ;  /* m_vnew - m_v */
+   DomainVector<Real_t> m_vdov ;  /* volume derivative over volume */
 
-   std::vector<Real_t> m_ss ;      /* "sound speed" */
+   DomainVector<Real_t> m_arealg ;  /* characteristic length of an element */
 
-   std::vector<Real_t> m_elemMass ;  /* mass */
+   DomainVector<Real_t> m_ss ;      /* "sound speed" */
 
    // Cutoffs (treat as constants)
    const Real_t  m_e_cut ;             // energy tolerance
@@ -562,6 +721,8 @@ class Domain {
    // Variables to keep track of timestep, simulation time, and cycle
    Real_t  m_dtcourant ;         // courant constraint
    Real_t  m_dthydro ;           // volume change constraint
+   std::atomic<Real_t> m_cycleDtCourant ;
+   std::atomic<Real_t> m_cycleDtHydro ;
    Int_t   m_cycle ;             // iteration count for simulation
    Real_t  m_dtfixed ;           // fixed time increment
    Real_t  m_time ;              // current time
@@ -599,9 +760,9 @@ class Domain {
 
 public:
 
-   std::vector<Real_t> fx_elem;
-   std::vector<Real_t> fy_elem;
-   std::vector<Real_t> fz_elem;
+   DomainVector<Real_t> fx_elem;
+   DomainVector<Real_t> fy_elem;
+   DomainVector<Real_t> fz_elem;
 
 } ;
 
@@ -628,6 +789,15 @@ Real_t CalcElemVolume( const Real_t x[8],
                        const Real_t y[8],
                        const Real_t z[8]);
 
+// Phases of a cycle timed with --phase-times (built with PHASE_TIMERS)
+enum CyclePhase { PhaseTimeIncrement, PhaseForces, PhaseNodal, PhaseKinematics,
+                  PhaseEOS, PhaseConstraints, NumCyclePhases } ;
+
+struct CyclePhaseTimes {
+   Int_t  cycle ;
+   double time[NumCyclePhases] ;  // seconds
+} ;
+
 // lulesh-util
 void ParseCommandLineOptions(hpx::program_options::variables_map &vm,
                              Int_t myRank, struct cmdLineOpts *opts);
@@ -635,6 +805,13 @@ void VerifyAndWriteFinalOutput(Real_t elapsed_time,
                                Domain& locDom,
                                Int_t nx,
                                Int_t numRanks);
+void PrintSampleStats(std::ostream &out, const char *name,
+                      std::vector<double> samples, double scale,
+                      const char *unit);
+void PrintPhaseTimes(std::ostream &out,
+                     std::vector<CyclePhaseTimes> const &cycles);
+bool WritePhaseTimes(std::string const &file,
+                     std::vector<CyclePhaseTimes> const &cycles);
 
 // lulesh-viz
 void DumpToVisit(Domain& domain, int numFiles, int myRank, int numRanks);
@@ -651,6 +828,13 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData);
 void CommSyncPosVel(Domain& domain);
 void CommMonoQ(Domain& domain);
 
+// Wall clock in seconds, used for optional task and phase statistics
+inline double WallTime()
+{
+   return std::chrono::duration<double>(
+      std::chrono::steady_clock::now().time_since_epoch()).count() ;
+}
+
 // lulesh-init
 void InitMeshDecomp(Int_t numRanks, Int_t myRank,
                     Int_t *col, Int_t *row, Int_t *plane, Int_t *side);
@@ -748,6 +932,8 @@ struct EvalEOSData {
     Real_t *vnewc_local;
     Real_t *vnewc;
     Real_t *ss;
+    double startTime; // only set with --eos-task-stats
+    double workTime;  // only accumulated in --eos-rebalance sample cycles
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,389 @@
+#!/bin/bash
+
+# Comparison runs for the tuning options of the HPX implementation.
+# Usage: bash run-ablation.sh <experiment> [size] [iterations]
+BASE=$PWD/..
+RESULT_DIR=$BASE/results
+LULESH_HPX_EXEC=$BASE/build/lulesh-hpx
+LULESH_REF_EXEC=$BASE/LULESH-reference-build/lulesh2.0
+HWLOC_LIB_PATH=$BASE/hpx-build/hpx-build/_deps/hwloc-installed/lib
+
+EXPERIMENT=$1
+SIZE=${2:-60}
+ITERATIONS=${3:-500}
+
+mkdir -p $RESULT_DIR
+
+run() {
+  LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --s $SIZE --i $ITERATIONS --q "$@"
+}
+
+case $EXPERIMENT in
+  eos-split)
+    # EOS task duration spread when splitting regions by size or by cost
+    RESULT_FILE=$RESULT_DIR/ablation_eos_split.txt
+    echo -n > $RESULT_FILE
+    for r in 11 16 21
+    do
+      for mode in size cost
+      do
+        echo "regions=$r eos-split=$mode" >> $RESULT_FILE
+        run --r $r --hpx:threads=24 --eos-split $mode --eos-task-stats >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  eos-priority)
+    # EOS phase makespan with and without priority launch of expensive regions
+    RESULT_FILE=$RESULT_DIR/ablation_eos_priority.txt
+    echo -n > $RESULT_FILE
+    for t in 24 48
+    do
+      for priority in "" "--eos-priority"
+      do
+        echo "threads=$t $priority" >> $RESULT_FILE
+        run --r 21 --hpx:threads=$t --eos-task-stats $priority >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  eos-rebalance)
+    # EOS chain imbalance with the static rep model and with measured re-chunking
+    RESULT_FILE=$RESULT_DIR/ablation_eos_rebalance.txt
+    echo -n > $RESULT_FILE
+    for c in 1 4
+    do
+      for rebalance in "" "--eos-rebalance 20"
+      do
+        echo "cost=$c $rebalance" >> $RESULT_FILE
+        run --r 21 --c $c --hpx:threads=24 --eos-task-stats $rebalance >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  eos-coalesce)
+    # Runtime with many small regions, with and without coalescing
+    RESULT_FILE=$RESULT_DIR/ablation_eos_coalesce.txt
+    echo -n > $RESULT_FILE
+    for r in 21 50 100
+    do
+      for coalesce in "" "--eos-coalesce"
+      do
+        echo "regions=$r $coalesce" >> $RESULT_FILE
+        run --r $r --hpx:threads=24 --eos-task-stats $coalesce >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  affinity)
+    # Runtime and cache misses with and without chunk-to-worker affinity
+    RESULT_FILE=$RESULT_DIR/ablation_affinity.txt
+    echo -n > $RESULT_FILE
+    for t in 24 48
+    do
+      for affinity in "" "--affinity"
+      do
+        echo "threads=$t $affinity" >> $RESULT_FILE
+        LD_LIBRARY_PATH=$HWLOC_LIB_PATH perf stat -x, -e cache-misses,LLC-load-misses,L1-dcache-load-misses \
+          $LULESH_HPX_EXEC --s $SIZE --i $ITERATIONS --q --hpx:threads=$t $affinity >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  l3-pools)
+    # Runtime and LLC misses with and without one thread pool per L3 domain
+    RESULT_FILE=$RESULT_DIR/ablation_l3_pools.txt
+    echo -n > $RESULT_FILE
+    for t in 24 48
+    do
+      for pools in "" "--l3-pools" "--l3-pools --affinity"
+      do
+        echo "threads=$t $pools" >> $RESULT_FILE
+        LD_LIBRARY_PATH=$HWLOC_LIB_PATH perf stat -x, -e cache-misses,LLC-load-misses,LLC-store-misses \
+          $LULESH_HPX_EXEC --s $SIZE --i $ITERATIONS --q --hpx:threads=$t $pools >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  memory-pool)
+    # Duration of the nodal phases for several thread counts of the memory pool;
+    # the efficiency of a phase is its single-thread time / (time x threads)
+    RESULT_FILE=$RESULT_DIR/ablation_memory_pool.txt
+    echo -n > $RESULT_FILE
+    for pool in "--hpx:threads=1" "--hpx:threads=48" "--hpx:threads=48 --memory-pool-threads 4" \
+                "--hpx:threads=48 --memory-pool-threads 8" "--hpx:threads=48 --memory-pool-threads 16"
+    do
+      echo "$pool" >> $RESULT_FILE
+      run $pool --pool-stats >> $RESULT_FILE 2>&1
+    done
+    ;;
+  nodal-overlap)
+    # Overlap of position updates and kinematics with chunk-level dependencies
+    RESULT_FILE=$RESULT_DIR/ablation_nodal_overlap.txt
+    echo -n > $RESULT_FILE
+    for SIZE in 45 90
+    do
+      for overlap in "" "--nodal-overlap" "--nodal-double-buffer"
+      do
+        echo "size=$SIZE $overlap" >> $RESULT_FILE
+        run --hpx:threads=24 --pool-stats $overlap >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  fused-pipeline)
+    # Element pipeline with a barrier before the EOS vs. neighbour dependencies
+    RESULT_FILE=$RESULT_DIR/ablation_fused_pipeline.txt
+    echo -n > $RESULT_FILE
+    for r in 11 21
+    do
+      for fused in "" "--fused-pipeline" "--fused-pipeline --nodal-overlap"
+      do
+        echo "regions=$r $fused" >> $RESULT_FILE
+        run --r $r --hpx:threads=24 --eos-task-stats $fused >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  tiles)
+    # Phase-ordered vs. tiled cycle: runtime and LLC misses (DRAM traffic),
+    # divide by the cycle count in the output for the traffic per cycle
+    RESULT_FILE=$RESULT_DIR/ablation_tiles.txt
+    echo -n > $RESULT_FILE
+    for tiles in "" "--tiles 1" "--tiles 2" "--tiles 4" "--tiles 8"
+    do
+      echo "size=$SIZE $tiles" >> $RESULT_FILE
+      LD_LIBRARY_PATH=$HWLOC_LIB_PATH perf stat -x, -e LLC-load-misses,LLC-store-misses \
+        $LULESH_HPX_EXEC --s $SIZE --i $ITERATIONS --q --hpx:threads=24 $tiles >> $RESULT_FILE 2>&1
+    done
+    ;;
+  co-tenancy)
+    # LULESH next to a CPU-bound neighbour job: runtime and suspend/resume
+    # latency of LULESH, bogo ops of the neighbour
+    RESULT_FILE=$RESULT_DIR/ablation_co_tenancy.txt
+    echo -n > $RESULT_FILE
+    for cotenancy in "" "--co-tenancy"
+    do
+      echo "$cotenancy" >> $RESULT_FILE
+      run --hpx:threads=24 >> $RESULT_FILE 2>&1
+      stress-ng --cpu 24 --timeout 60s --metrics-brief >> $RESULT_FILE 2>&1 &
+      STRESS_PID=$!
+      run --hpx:threads=24 $cotenancy >> $RESULT_FILE 2>&1
+      wait $STRESS_PID
+    done
+    ;;
+  small-path)
+    # Small problems: task graph vs. fork-join cycle vs. OpenMP reference
+    RESULT_FILE=$RESULT_DIR/ablation_small_path.txt
+    echo -n > $RESULT_FILE
+    for SIZE in 10 20 30
+    do
+      for t in 4 24
+      do
+        echo "size=$SIZE threads=$t small-path=tasks" >> $RESULT_FILE
+        run --hpx:threads=$t --small-path tasks >> $RESULT_FILE 2>&1
+        for work in 1024 4096 16384
+        do
+          echo "size=$SIZE threads=$t small-path=forkjoin fork-join-task-work=$work" >> $RESULT_FILE
+          run --hpx:threads=$t --small-path forkjoin --fork-join-task-work $work >> $RESULT_FILE 2>&1
+        done
+        echo "size=$SIZE threads=$t openmp" >> $RESULT_FILE
+        OMP_NUM_THREADS=$t $LULESH_REF_EXEC -s $SIZE -i $ITERATIONS -q >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  constraints)
+    # Time constraints in the EOS save tasks vs. in a separate phase
+    RESULT_FILE=$RESULT_DIR/ablation_constraints.txt
+    echo -n > $RESULT_FILE
+    for t in 24 48
+    do
+      for constraints in "" "--separate-constraints"
+      do
+        echo "threads=$t $constraints" >> $RESULT_FILE
+        run --hpx:threads=$t --small-path tasks $constraints >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  lagged-dt)
+    # Synchronous vs. lagged time step: runtime to the stop time, cycle count
+    # and synchronous fallbacks for several safety factors
+    RESULT_FILE=$RESULT_DIR/ablation_lagged_dt.txt
+    echo -n > $RESULT_FILE
+    for lagged in "" "--separate-constraints" "--lagged-dt 0.95" "--lagged-dt 0.9" "--lagged-dt 0.8"
+    do
+      echo "size=$SIZE $lagged" >> $RESULT_FILE
+      LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --s $SIZE --q --hpx:threads=24 --small-path tasks $lagged >> $RESULT_FILE 2>&1
+    done
+    ;;
+  max-eos-chains)
+    # Peak memory vs. throughput (FOM) for several limits of EOS chains in flight
+    RESULT_FILE=$RESULT_DIR/ablation_max_eos_chains.txt
+    echo -n > $RESULT_FILE
+    for chains in 0 24 48 96 192
+    do
+      echo "size=$SIZE max-eos-chains=$chains" >> $RESULT_FILE
+      run --hpx:threads=24 --eos-task-stats --max-eos-chains $chains >> $RESULT_FILE 2>&1
+    done
+    ;;
+  startup)
+    # Setup time breakdown for several thread counts, a single cycle each
+    RESULT_FILE=$RESULT_DIR/ablation_startup.txt
+    echo -n > $RESULT_FILE
+    for t in 1 12 24 48
+    do
+      echo "size=$SIZE threads=$t" >> $RESULT_FILE
+      LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --s $SIZE --i 1 --q --hpx:threads=$t --startup-stats >> $RESULT_FILE 2>&1
+    done
+    ;;
+  phase-times)
+    # Per-phase times of the task graph and fork-join cycles for several
+    # thread counts; needs a build with -DWITH_PHASE_TIMERS=ON
+    RESULT_FILE=$RESULT_DIR/ablation_phase_times.txt
+    echo -n > $RESULT_FILE
+    for t in 12 24 48
+    do
+      for mode in tasks forkjoin
+      do
+        echo "size=$SIZE threads=$t small-path=$mode" >> $RESULT_FILE
+        run --hpx:threads=$t --small-path $mode --phase-times $RESULT_DIR/phase_times_${t}_$mode.json >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  kernel-counters)
+    # Hardware counters per kernel for problem sizes from in-cache to
+    # memory-bound
+    RESULT_FILE=$RESULT_DIR/ablation_kernel_counters.txt
+    echo -n > $RESULT_FILE
+    for SIZE in 30 60 90 120
+    do
+      echo "size=$SIZE" >> $RESULT_FILE
+      run --hpx:threads=24 --kernel-counters >> $RESULT_FILE 2>&1
+    done
+    ;;
+  roofline)
+    # Achieved bandwidth and flop rate per kernel against the measured peaks,
+    # from in-cache to memory-bound problem sizes
+    RESULT_FILE=$RESULT_DIR/ablation_roofline.txt
+    echo -n > $RESULT_FILE
+    for SIZE in 30 60 90 120
+    do
+      for t in 1 24
+      do
+        echo "size=$SIZE threads=$t" >> $RESULT_FILE
+        run --hpx:threads=$t --roofline >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  alloc-stats)
+    # Allocations per cycle of the cycle modes and of the fused pipeline;
+    # needs a build with -DWITH_ALLOC_STATS=ON
+    RESULT_FILE=$RESULT_DIR/ablation_alloc_stats.txt
+    echo -n > $RESULT_FILE
+    for mode in tasks forkjoin
+    do
+      echo "size=$SIZE small-path=$mode" >> $RESULT_FILE
+      run --hpx:threads=24 --small-path $mode --alloc-stats >> $RESULT_FILE 2>&1
+    done
+    echo "size=$SIZE fused-pipeline" >> $RESULT_FILE
+    run --hpx:threads=24 --fused-pipeline --alloc-stats >> $RESULT_FILE 2>&1
+    ;;
+  counters)
+    # LULESH performance counters sampled together with the idle rate of the
+    # workers once per second
+    RESULT_FILE=$RESULT_DIR/ablation_counters.txt
+    echo -n > $RESULT_FILE
+    for t in 12 24 48
+    do
+      echo "size=$SIZE threads=$t" >> $RESULT_FILE
+      run --hpx:threads=$t --hpx:print-counter=/lulesh/cycle --hpx:print-counter=/lulesh/fom \
+        --hpx:print-counter=/lulesh/tasks-per-cycle --hpx:print-counter=/lulesh/eos-rep-work \
+        --hpx:print-counter=/threads/idle-rate --hpx:print-counter-interval=1000 >> $RESULT_FILE 2>&1
+    done
+    ;;
+  ensemble)
+    # Parameter sweep of small runs as separate processes vs. one ensemble
+    # run: total wall time and the result line of each configuration
+    RESULT_FILE=$RESULT_DIR/ablation_ensemble.txt
+    CONFIG_FILE=$RESULT_DIR/ablation_ensemble_configs.txt
+    echo -n > $RESULT_FILE
+    echo "# s r b c" > $CONFIG_FILE
+    for s in 10 15 20 25 30
+    do
+      for r in 11 21
+      do
+        for c in 1 2
+        do
+          echo "$s $r 1 $c" >> $CONFIG_FILE
+        done
+      done
+    done
+    echo "separate processes" >> $RESULT_FILE
+    start=$(date +%s.%N)
+    grep -v '^#' $CONFIG_FILE | while read s r b c
+    do
+      LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --s $s --r $r --b $b --c $c --i $ITERATIONS --q --hpx:threads=24 >> $RESULT_FILE 2>&1
+    done
+    echo "total wall time: $(echo "$(date +%s.%N) - $start" | bc) s" >> $RESULT_FILE
+    for jobs in 4 12 24
+    do
+      echo "ensemble jobs=$jobs" >> $RESULT_FILE
+      start=$(date +%s.%N)
+      LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --ensemble $CONFIG_FILE --ensemble-jobs $jobs --i $ITERATIONS --q --hpx:threads=24 >> $RESULT_FILE 2>&1
+      echo "total wall time: $(echo "$(date +%s.%N) - $start" | bc) s" >> $RESULT_FILE
+    done
+    ;;
+  serve)
+    # Stream of short jobs as separate processes vs. one job server that
+    # keeps the runtime and reuses the domains of the same size
+    RESULT_FILE=$RESULT_DIR/ablation_serve.txt
+    SPOOL_DIR=$RESULT_DIR/spool
+    echo -n > $RESULT_FILE
+    rm -rf $SPOOL_DIR
+    mkdir -p $SPOOL_DIR
+    echo "separate processes" >> $RESULT_FILE
+    start=$(date +%s.%N)
+    for job in $(seq 1 20)
+    do
+      LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --s $SIZE --r $((11 + job % 3 * 5)) --i $ITERATIONS --q --hpx:threads=24 >> $RESULT_FILE 2>&1
+    done
+    echo "total wall time: $(echo "$(date +%s.%N) - $start" | bc) s" >> $RESULT_FILE
+    echo "job server" >> $RESULT_FILE
+    LD_LIBRARY_PATH=$HWLOC_LIB_PATH $LULESH_HPX_EXEC --serve $SPOOL_DIR --q --hpx:threads=24 >> $RESULT_FILE 2>&1 &
+    start=$(date +%s.%N)
+    for job in $(seq 1 20)
+    do
+      echo "$SIZE $((11 + job % 3 * 5)) 1 1 $ITERATIONS" > $SPOOL_DIR/job$job.tmp
+      mv $SPOOL_DIR/job$job.tmp $SPOOL_DIR/job$job.job
+      while [ ! -f $SPOOL_DIR/job$job.out ]; do sleep 0.01; done
+      cat $SPOOL_DIR/job$job.out >> $RESULT_FILE
+    done
+    echo "total wall time: $(echo "$(date +%s.%N) - $start" | bc) s" >> $RESULT_FILE
+    touch $SPOOL_DIR/stop
+    wait
+    ;;
+  tree-spawn)
+    # Single spawner vs. one spawner per region: time until the last EOS and
+    # constraint task starts, many small tasks to stress task creation
+    RESULT_FILE=$RESULT_DIR/ablation_tree_spawn.txt
+    echo -n > $RESULT_FILE
+    for t in 24 48 96
+    do
+      for spawn in "" "--tree-spawn"
+      do
+        echo "threads=$t $spawn" >> $RESULT_FILE
+        run --r 100 --hpx:threads=$t --elems-per-task 512 --spawn-stats $spawn >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  lazy-split)
+    # Fixed task sizes vs. lazy splitting for different grain and problem sizes
+    RESULT_FILE=$RESULT_DIR/ablation_lazy_split.txt
+    echo -n > $RESULT_FILE
+    for SIZE in 45 60 90
+    do
+      for split in "" "--lazy-split 128" "--lazy-split 512" "--lazy-split 2048"
+      do
+        echo "size=$SIZE $split" >> $RESULT_FILE
+        run --r 21 --hpx:threads=24 --eos-task-stats $split >> $RESULT_FILE 2>&1
+      done
+    done
+    ;;
+  *)
+    echo "Unknown experiment '$EXPERIMENT'"
+    echo "Available experiments: eos-split eos-priority eos-rebalance eos-coalesce affinity l3-pools memory-pool nodal-overlap fused-pipeline tiles co-tenancy small-path constraints lagged-dt max-eos-chains startup phase-times kernel-counters roofline alloc-stats counters ensemble serve tree-spawn lazy-split"
+    exit 1
+    ;;
+esac